@@ -0,0 +1,203 @@
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+
+extern "C" {
+#include "rts_parser.h"
+}
+
+// Analytical schedulability tests on a parsed periodic task set, used to
+// answer without simulating whenever a test is conclusive.
+//
+// The tests model the simulator's semantics, not the textbook ones, where
+// they differ:
+//  - jobs are released on multiples of the period once the release time has
+//    passed, so every task releases together at each hyperperiod boundary
+//    and the synchronous critical instant does occur in the simulated window;
+//  - a job with zero execution time still occupies one tick;
+//  - equal priorities are served in release order.
+// Only constrained deadlines (D <= P) are analysed. Each job is then
+// finished or dropped before its task's next release, so the processor is
+// empty at the critical instant. Sets with D > P are left undecided.
+
+enum Verdict { UNDECIDED, SCHEDULABLE, UNSCHEDULABLE };
+
+struct Analysis {
+    Verdict verdict;
+    std::string test; // which test decided, empty when undecided
+};
+
+// Iterative analyses give up beyond this many time units
+const long long ANALYSIS_LIMIT = 1000000000LL;
+
+struct AnalysedTask {
+    long long C, P, D;
+    int index; // position in the input, i.e. release order at equal times
+};
+
+// Periodic and dynamic tasks that actually release jobs
+static std::vector<AnalysedTask> analysedTasks(const ParserState* state, bool& constrained) {
+    std::vector<AnalysedTask> tasks;
+    constrained = true;
+    for (int i = 0; i < state->task_count; i++) {
+        const ParsedTask* t = &state->tasks[i];
+        if (t->type == PARSED_TASK_APERIODIC || t->period <= 0) continue;
+        long long d = t->deadline > 0 ? t->deadline : t->period;
+        tasks.push_back({std::max<long long>(t->execution_time, 1), t->period, d, i});
+        if (d > t->period) constrained = false;
+    }
+    return tasks;
+}
+
+static double utilization(const std::vector<AnalysedTask>& tasks) {
+    double u = 0;
+    for (const auto& t : tasks) u += (double)t.C / t.P;
+    return u;
+}
+
+// Worst-case response time of `task` against the interfering set, or -1
+// once it exceeds `bound`
+static long long responseTime(const AnalysedTask& task, const std::vector<const AnalysedTask*>& interference,
+                              long long bound) {
+    long long r = task.C;
+    for (const auto* t : interference) r += t->C;
+    while (r <= bound) {
+        long long next = task.C;
+        for (const auto* t : interference) next += (r + t->P - 1) / t->P * t->C;
+        if (next == r) return r;
+        r = next;
+    }
+    return -1;
+}
+
+// Response-time analysis for a fixed-priority order given by `key` (period
+// for RM, deadline for DM). A task is safe when its response time counting
+// every task of higher or equal priority fits its deadline, and certainly
+// misses when even the strictly higher ones push it past the deadline.
+static Analysis fixedPriorityRTA(const std::vector<AnalysedTask>& tasks, long long AnalysedTask::*key) {
+    bool all_safe = true;
+    for (const auto& task : tasks) {
+        std::vector<const AnalysedTask*> higher, higher_or_equal;
+        for (const auto& other : tasks) {
+            if (&other == &task) continue;
+            if (other.*key < task.*key) higher.push_back(&other);
+            if (other.*key <= task.*key) higher_or_equal.push_back(&other);
+        }
+        if (responseTime(task, higher, task.D) < 0) return {UNSCHEDULABLE, "response-time analysis"};
+        if (responseTime(task, higher_or_equal, task.D) < 0) all_safe = false;
+    }
+    if (all_safe) return {SCHEDULABLE, "response-time analysis"};
+    return {UNDECIDED, ""};
+}
+
+// Processor demand of all jobs with release and deadline inside [0, t]
+static long long demand(const std::vector<AnalysedTask>& tasks, long long t) {
+    long long h = 0;
+    for (const auto& task : tasks) {
+        if (t >= task.D) h += ((t - task.D) / task.P + 1) * task.C;
+    }
+    return h;
+}
+
+// Latest absolute deadline strictly before t, or -1
+static long long deadlineBefore(const std::vector<AnalysedTask>& tasks, long long t) {
+    long long best = -1;
+    for (const auto& task : tasks) {
+        if (t <= task.D) continue;
+        long long k = (t - task.D - 1) / task.P;
+        best = std::max(best, k * task.P + task.D);
+    }
+    return best;
+}
+
+// Quick Processor-demand Analysis (Zhang & Burns) over the synchronous busy
+// period. Exact for constrained deadlines: a demand overflow means every
+// scheduler misses a deadline.
+static Analysis processorDemand(const std::vector<AnalysedTask>& tasks) {
+    if (utilization(tasks) > 1.0) return {UNSCHEDULABLE, "utilization > 1"};
+
+    // Length of the synchronous busy period
+    long long busy = 0;
+    for (const auto& t : tasks) busy += t.C;
+    while (true) {
+        long long next = 0;
+        for (const auto& t : tasks) next += (busy + t.P - 1) / t.P * t.C;
+        if (next == busy) break;
+        if (next > ANALYSIS_LIMIT) return {UNDECIDED, ""};
+        busy = next;
+    }
+
+    long long d_min = ANALYSIS_LIMIT;
+    for (const auto& t : tasks) d_min = std::min(d_min, t.D);
+
+    long long t = deadlineBefore(tasks, busy + 1);
+    while (t >= 0) {
+        long long h = demand(tasks, t);
+        if (h > t) return {UNSCHEDULABLE, "processor demand analysis"};
+        if (h <= d_min) break;
+        t = h < t ? h : deadlineBefore(tasks, t);
+    }
+    return {SCHEDULABLE, "processor demand analysis"};
+}
+
+// Decides `scheduler` ("RM", "DM", "EDF" or "LLF") on analysed tasks when
+// one of the tests is conclusive. `constrained`: every D <= P.
+Analysis analyzeTasks(const std::vector<AnalysedTask>& tasks, bool constrained, const std::string& scheduler) {
+    if (tasks.empty()) return {SCHEDULABLE, "no periodic tasks"};
+    if (!constrained) return {UNDECIDED, ""};
+
+    // Demand overflow defeats every policy
+    Analysis demand_test = processorDemand(tasks);
+    if (demand_test.verdict == UNSCHEDULABLE) return demand_test;
+    if (scheduler == "EDF") return demand_test;
+
+    if (scheduler == "RM" || scheduler == "DM") {
+        bool implicit = true;
+        for (const auto& t : tasks) implicit = implicit && t.D == t.P;
+        if (implicit) {
+            // With D = P both orders coincide with rate monotonic
+            double n = tasks.size();
+            if (utilization(tasks) <= n * (std::pow(2.0, 1.0 / n) - 1)) return {SCHEDULABLE, "Liu & Layland bound"};
+            double product = 1;
+            for (const auto& t : tasks) product *= (double)t.C / t.P + 1;
+            if (product <= 2.0) return {SCHEDULABLE, "hyperbolic bound"};
+        }
+        return fixedPriorityRTA(tasks, scheduler == "RM" ? &AnalysedTask::P : &AnalysedTask::D);
+    }
+    return {UNDECIDED, ""};
+}
+
+// Decides `scheduler` on the periodic part of the set when one of the tests
+// is conclusive
+Analysis analyzeSchedulability(const ParserState* state, const std::string& scheduler) {
+    bool constrained;
+    std::vector<AnalysedTask> tasks = analysedTasks(state, constrained);
+    return analyzeTasks(tasks, constrained, scheduler);
+}
+
+// Static speed scaling: the lowest of `speeds` (ascending) at which the test
+// for `scheduler` proves the set schedulable with every task at its HI
+// execution time, stretched to the speed; the highest speed if none does.
+// The mixed-criticality policies are tested as the policy they reduce to
+// with every job at its HI execution time. `test` receives the deciding test.
+double staticSpeed(const ParserState* state, const std::string& scheduler, const std::vector<double>& speeds,
+                   std::string& test) {
+    std::string policy = scheduler == "EDF-VD" ? "EDF" : scheduler == "AMC" ? "RM" : scheduler;
+    bool constrained;
+    std::vector<AnalysedTask> tasks = analysedTasks(state, constrained);
+    test = "";
+    for (double s : speeds) {
+        std::vector<AnalysedTask> scaled = tasks;
+        for (auto& t : scaled) {
+            long long c = std::max(state->tasks[t.index].execution_time_hi, 1);
+            t.C = std::max<long long>((long long)std::ceil(c / s - 1e-9), 1);
+        }
+        Analysis analysis = analyzeTasks(scaled, constrained, policy);
+        if (analysis.verdict == SCHEDULABLE) {
+            test = analysis.test;
+            return s;
+        }
+    }
+    return speeds.back();
+}
@@ -0,0 +1,308 @@
+#include "setup_ali.cpp"
+#include "taskgen_ali.cpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "rts_parser.h"
+}
+
+using namespace std;
+
+// Microbenchmarks for the simulator, written as JSON in the layout of
+// Google Benchmark's --benchmark_format=json so its compare tools can diff
+// two runs. Every benchmark repeats its body in growing batches until one
+// batch takes --min-time seconds, and reports time per iteration plus its
+// own counters:
+//  - select/<policy>/<n>: one selectTask() on a ready queue of n jobs
+//  - requeue/<policy>/<n>: select, remove and re-add the selected job
+//  - simulate/<policy>/<tasks>/<horizon>: a whole simulate() run of a
+//    generated set; events_per_second counts scheduling decisions and
+//    allocs_per_job the C++ heap allocations per released job
+//  - parse/<sets>x<tasks>: parse_buffer over an in-memory multi-set text
+
+// Heap allocations through operator new, for allocs_per_job. The
+// replacements stay out of line: inlined, every delete in the program would
+// show up as a free() of memory from operator new.
+static long allocations = 0;
+
+__attribute__((noinline)) void* operator new(size_t size) {
+    allocations++;
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+
+struct BenchResult {
+    string name;
+    long iterations;
+    double seconds;                          // wall time of the measured batch
+    double cpu_seconds;                      // process CPU time of the same batch
+    vector<pair<string, double>> counters;   // per-benchmark extras
+};
+
+struct Bench {
+    double min_time = 0.2;
+    string filter;
+    vector<BenchResult> results;
+
+    bool selected(const string& name) { return filter.empty() || name.find(filter) != string::npos; }
+
+    // Times body(iterations) with growing batches; returns the last batch
+    BenchResult& run(const string& name, const function<void(long)>& body) {
+        long iterations = 1;
+        double seconds = 0, cpu_seconds = 0;
+        while (true) {
+            auto start = chrono::steady_clock::now();
+            clock_t cpu_start = clock();
+            body(iterations);
+            cpu_seconds = (double)(clock() - cpu_start) / CLOCKS_PER_SEC;
+            seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (seconds >= min_time || iterations >= (1L << 30)) break;
+            // Aim a little past the target from the measured rate
+            double grow = seconds > 0 ? min_time * 1.4 / seconds : 10;
+            iterations = max(iterations + 1, (long)(iterations * min(max(grow, 2.0), 10.0)));
+        }
+        results.push_back({name, iterations, seconds, cpu_seconds, {}});
+        cerr << name << ": " << seconds * 1e9 / iterations << " ns" << endl;
+        return results.back();
+    }
+};
+
+static bool isServerPolicy(const string& name) {
+    return name == "Background" || name == "Poller" || name == "Deferrable" || name == "Sporadic" || name == "TBS" ||
+           name == "CBS";
+}
+
+// Scheduler by sweep-style policy name
+static Scheduler* makeScheduler(const string& name, const ParsedServerConfig& server) {
+    if (!isServerPolicy(name)) return makePeriodicScheduler(name);
+    ParsedServerConfig config = server;
+    if (name == "Background") config.type = SERVER_BACKGROUND;
+    else if (name == "Poller") config.type = SERVER_POLLER;
+    else if (name == "Sporadic") config.type = SERVER_SPORADIC;
+    else if (name == "TBS") config.type = SERVER_TBS;
+    else if (name == "CBS") config.type = SERVER_CBS;
+    else config.type = SERVER_DEFERRABLE;
+    return makeServerScheduler(config);
+}
+
+static const char* BENCH_POLICIES[] = {"RM", "DM", "EDF", "LLF", "Background",
+                                       "Poller", "Deferrable", "Sporadic", "TBS", "CBS"};
+
+static ParsedServerConfig benchServer() {
+    ParsedServerConfig server;
+    server.type = SERVER_POLLER;
+    server.budget = 20;
+    server.period = 100;
+    server.scheduling = SCHED_RM;
+    return server;
+}
+
+// Ready queues of n jobs: distinct periods and deadlines, one job of every
+// fourth task aperiodic so the servers have both queues filled
+static void benchSelect(Bench& bench, const string& policy, int n) {
+    string select_name = "select/" + policy + "/" + to_string(n);
+    string requeue_name = "requeue/" + policy + "/" + to_string(n);
+    if (!bench.selected(select_name) && !bench.selected(requeue_name)) return;
+
+    bool server = isServerPolicy(policy);
+    vector<Task> tasks;
+    for (int i = 0; i < n; i++) {
+        bool aperiodic = server && i % 4 == 3;
+        tasks.emplace_back(aperiodic ? Aperiodic : Periodic, 1 + i % 7, 10 * (i + 1), 0, 0);
+    }
+    JobPool pool;
+    vector<Job*> jobs;
+    for (int i = 0; i < n; i++) jobs.push_back(pool.create(&tasks[i], 0, (long)i));
+
+    Scheduler* sch = makeScheduler(policy, benchServer());
+    sch->prepare(tasks);
+    for (Job* job : jobs) sch->addReady(job);
+    sch->budgetReplenishment();
+
+    if (bench.selected(select_name)) {
+        volatile long sink = 0;
+        bench.run(select_name, [&](long iterations) {
+            for (long k = 0; k < iterations; k++) sink += (long)(size_t)sch->selectTask();
+        });
+    }
+    if (bench.selected(requeue_name)) {
+        bench.run(requeue_name, [&](long iterations) {
+            for (long k = 0; k < iterations; k++) {
+                Job* job = sch->selectTask();
+                if (!job) continue;
+                sch->removeReady(job);
+                sch->addReady(job);
+            }
+        });
+    }
+    delete sch;
+    for (Job* job : jobs) pool.destroy(job);
+}
+
+// simulate() end to end on a generated set of utilization 0.8
+static void benchSimulate(Bench& bench, const string& policy, int task_count, double length) {
+    string name = "simulate/" + policy + "/" + to_string(task_count) + "/" + to_string((long)length);
+    if (!bench.selected(name)) return;
+
+    GeneratorConfig config;
+    config.tasks = task_count;
+    config.aperiodic = 10;
+    mt19937_64 rng = setStream(1, task_count, 0);
+    ParserState state;
+    init_parser_state(&state);
+    generateTaskSet(rng, config, 0.8, &state);
+    bool server = isServerPolicy(policy);
+    if (server) addAperiodicRequests(rng, config, &state);
+    vector<Task> tasks;
+    loadTasksFromParser(&state, tasks);
+    free_parser_state(&state);
+
+    SimHorizon horizon(length);
+    SimResult last;
+    double allocated = 0;
+    BenchResult& result = bench.run(name, [&](long iterations) {
+        long before = allocations;
+        for (long k = 0; k < iterations; k++) {
+            Scheduler* sch = makeScheduler(policy, benchServer());
+            last = simulate(sch, tasks, horizon, server);
+            delete sch;
+        }
+        allocated = (double)(allocations - before) / iterations;
+    });
+    result.counters.push_back({"events_per_second", last.events * result.iterations / result.seconds});
+    result.counters.push_back({"jobs", (double)last.released});
+    result.counters.push_back({"allocs_per_job", last.released > 0 ? allocated / last.released : 0});
+}
+
+// Text of `sets` generated sets of `task_count` tasks each, as rts_pack --unpack prints it
+static string benchText(int sets, int task_count) {
+    GeneratorConfig config;
+    config.tasks = task_count;
+    ParserState state;
+    init_parser_state(&state);
+    string text;
+    char line[96];
+    for (int s = 0; s < sets; s++) {
+        mt19937_64 rng = setStream(2, task_count, s);
+        generateTaskSet(rng, config, 0.8, &state);
+        if (s > 0) text += string(SET_DELIMITER) + "\n";
+        for (int i = 0; i < state.task_count; i++) {
+            const ParsedTask& t = state.tasks[i];
+            snprintf(line, sizeof(line), "P %d %d %d %d\n", t.release_time, t.execution_time, t.period, t.deadline);
+            text += line;
+        }
+    }
+    free_parser_state(&state);
+    return text;
+}
+
+static int countSet(ParserState* state, int set_index, void* user) {
+    (void)set_index;
+    *(long*)user += state->task_count;
+    return 0;
+}
+
+static void benchParse(Bench& bench, int sets, int task_count) {
+    string name = "parse/" + to_string(sets) + "x" + to_string(task_count);
+    if (!bench.selected(name)) return;
+    string text = benchText(sets, task_count);
+    long parsed = 0;
+    BenchResult& result = bench.run(name, [&](long iterations) {
+        for (long k = 0; k < iterations; k++) parse_buffer(text.data(), text.size(), "bench", countSet, &parsed);
+    });
+    result.counters.push_back({"bytes_per_second", text.size() * result.iterations / result.seconds});
+    result.counters.push_back({"megabytes_per_second", text.size() * result.iterations / result.seconds / 1e6});
+}
+
+static string jsonString(const string& s) {
+    string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+void writeJson(const Bench& bench, ostream& out) {
+    char date[32];
+    time_t now = time(NULL);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": " << jsonString(date) << ",\n"
+        << "    \"executable\": \"bench.exe\",\n"
+        << "    \"num_cpus\": " << thread::hardware_concurrency() << ",\n"
+        << "    \"min_time\": " << bench.min_time << "\n"
+        << "  },\n  \"benchmarks\": [";
+    out.precision(10);
+    for (size_t i = 0; i < bench.results.size(); i++) {
+        const BenchResult& r = bench.results[i];
+        out << (i ? "," : "") << "\n    {\n"
+            << "      \"name\": " << jsonString(r.name) << ",\n"
+            << "      \"run_type\": \"iteration\",\n"
+            << "      \"iterations\": " << r.iterations << ",\n"
+            << "      \"real_time\": " << r.seconds * 1e9 / r.iterations << ",\n"
+            << "      \"cpu_time\": " << r.cpu_seconds * 1e9 / r.iterations << ",\n"
+            << "      \"time_unit\": \"ns\"";
+        for (const auto& counter : r.counters) out << ",\n      " << jsonString(counter.first) << ": " << counter.second;
+        out << "\n    }";
+    }
+    out << "\n  ]\n}" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    // --filter S    only the benchmarks whose name contains S
+    // --min-time T  seconds each measured batch must last
+    // -o FILE       write the JSON there instead of stdout
+    Bench bench;
+    string output;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            bench.filter = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            bench.min_time = atof(argv[++i]);
+        } else if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            cerr << "Usage: " << argv[0] << " [--filter S] [--min-time T] [-o results.json]" << endl;
+            return 1;
+        }
+    }
+
+    for (const char* policy : BENCH_POLICIES) {
+        for (int n : {8, 64, 512, 4096}) benchSelect(bench, policy, n);
+    }
+    for (const char* policy : BENCH_POLICIES) {
+        for (int task_count : {5, 20, 100}) {
+            for (double length : {1e4, 1e5}) benchSimulate(bench, policy, task_count, length);
+        }
+    }
+    benchParse(bench, 100, 10);
+    benchParse(bench, 10000, 10);
+
+    if (output.empty()) {
+        writeJson(bench, cout);
+        return 0;
+    }
+    ofstream out(output);
+    writeJson(bench, out);
+    if (!out) {
+        cerr << "Error: Cannot write '" << output << "'" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <numeric>
+#include <cmath>
+#include <algorithm>
+
+extern "C" {
+#include "rts_parser.h"
+}
+
+// How long simulate() runs. With a hyperperiod set, the release pattern is
+// periodic from `offset` on, and the run also stops at the first boundary
+// offset + k * hyperperiod whose state equals the one at an earlier
+// boundary: from there on the schedule just repeats. Lengths are in ticks, of which
+// `resolution` make one time unit of the input.
+struct SimHorizon {
+    Tick length;             // hard end of the simulation
+    Tick offset = 0;
+    Tick hyperperiod = 0;    // 0 disables the repeat check (fixed-length run)
+    bool clamped = false;    // the hyperperiod did not fit under the limit
+    Tick resolution = 1;
+
+    SimHorizon(Tick len = 0, Tick res = 1) : length(len), resolution(res) {}
+
+    // Ticks covering `units` time units, rounded up; NEVER past the Tick range
+    Tick ticks(double units) const {
+        double t = std::ceil(units * resolution);
+        return t < (double)NEVER ? (Tick)t : NEVER;
+    }
+    // Time units of `t` ticks, for reports
+    double units(Tick t) const { return (double)t / resolution; }
+};
+
+// Longest run computeHorizon() will schedule, in time units
+const double HORIZON_LIMIT = 1e9;
+// Finest resolution (ticks per time unit) the front ends accept: every time
+// the parser reads (an int) and HORIZON_LIMIT time units still fit a Tick
+const Tick RESOLUTION_LIMIT = 1000000000;
+
+// Least common multiple that saturates at `limit` instead of overflowing
+static long long boundedLcm(long long a, long long b, long long limit, bool& clamped) {
+    long long q = a / std::gcd(a, b);
+    if (q > limit / b) {
+        clamped = true;
+        return limit;
+    }
+    return std::min(q * b, limit);
+}
+
+// Derives the simulation horizon from the parsed task set: the hyperperiod H
+// is the LCM of all task periods (and the server period, if any), and the
+// offset O is the latest release time. Releases repeat every H from O on, so
+// [O, O + H) is the steady-state window; the run is capped at O + 2H, plus
+// enough extra hyperperiods to let a server drain every aperiodic request at
+// one unit per server period. `limit` is in time units; the result is in
+// ticks of the given resolution. The cap is lowered to what fits a Tick at
+// that resolution, so no scaled time overflows.
+SimHorizon computeHorizon(const ParserState* state, double limit = HORIZON_LIMIT, Tick resolution = 1) {
+    long long max_cap = NEVER / resolution;
+    long long cap = limit >= (double)max_cap ? max_cap : (long long)limit;
+    long long hyper = 1;
+    long long offset = 0;
+    long long aperiodic_work = 0;
+    bool clamped = false;
+
+    for (int i = 0; i < state->task_count; i++) {
+        const ParsedTask* t = &state->tasks[i];
+        offset = std::max(offset, (long long)t->release_time);
+        if (t->type == PARSED_TASK_APERIODIC) {
+            aperiodic_work += std::max(t->execution_time, 0);
+        } else if (t->period > 0) {
+            hyper = boundedLcm(hyper, t->period, cap, clamped);
+        }
+    }
+    bool server = state->server.type != SERVER_NONE;
+    if (server && state->server.period > 0) {
+        hyper = boundedLcm(hyper, state->server.period, cap, clamped);
+    }
+
+    long long periods = 2;
+    if (server) {
+        long long drain = aperiodic_work * std::max(state->server.period, 1);
+        periods += (drain + hyper - 1) / hyper;
+    }
+
+    SimHorizon horizon(0, resolution);
+    if (clamped || offset > cap || periods > (cap - offset) / hyper) {
+        horizon.length = cap * resolution;
+        horizon.clamped = true;
+    } else {
+        horizon.offset = offset * resolution;
+        horizon.hyperperiod = hyper * resolution;
+        horizon.length = (offset + periods * hyper) * resolution;
+    }
+    return horizon;
+}
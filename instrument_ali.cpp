@@ -0,0 +1,198 @@
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// Hot-path instrumentation of the simulation loops: event counts and the
+// time spent in each phase of an event, on the processor's cycle counter.
+// Compiled in only with RTS_INSTRUMENT=1 (make INSTRUMENT=1); otherwise
+// the hooks (SimProbe, countBudget) are empty and the loops are unchanged.
+//
+// Each thread counts into its own SimCounters, so the hooks never share a
+// cache line or take a lock. A run reports what its thread counted while it
+// ran (SimResult::counters); allCounters() merges the threads at the end.
+
+#ifndef RTS_INSTRUMENT
+#define RTS_INSTRUMENT 0
+#endif
+
+enum SimPhase {
+    PHASE_RELEASE,    // expiring timers, job releases
+    PHASE_MISS_CHECK, // deadline misses
+    PHASE_SELECT,     // replenishment and the scheduling decision
+    PHASE_EXECUTE,    // running the selected jobs up to the next event
+    PHASE_OTHER,      // state-repeat checks and the rest of the loop
+    SIM_PHASES
+};
+
+const char* const SIM_PHASE_NAMES[SIM_PHASES] = {"release", "miss-check", "select", "execute", "other"};
+
+struct SimCounters {
+    uint64_t selects = 0;          // scheduling decisions (selectTask / selectTasks calls)
+    uint64_t context_switches = 0; // a core starts running another job
+    uint64_t preemptions = 0;      // ... while the job it ran is not done
+    uint64_t releases = 0;
+    uint64_t deadline_checks = 0;  // miss checks, one per decision
+    uint64_t replenishments = 0;   // a server budget is refilled
+    uint64_t consumptions = 0;     // a server job runs on budget
+    uint64_t consumed = 0;         // ... ticks charged to the budget
+    uint64_t cycles[SIM_PHASES] = {};
+
+    void add(const SimCounters& other) {
+        selects += other.selects;
+        context_switches += other.context_switches;
+        preemptions += other.preemptions;
+        releases += other.releases;
+        deadline_checks += other.deadline_checks;
+        replenishments += other.replenishments;
+        consumptions += other.consumptions;
+        consumed += other.consumed;
+        for (int p = 0; p < SIM_PHASES; p++) cycles[p] += other.cycles[p];
+    }
+
+    // What was counted since `before`
+    SimCounters since(const SimCounters& before) const {
+        SimCounters d = *this;
+        d.selects -= before.selects;
+        d.context_switches -= before.context_switches;
+        d.preemptions -= before.preemptions;
+        d.releases -= before.releases;
+        d.deadline_checks -= before.deadline_checks;
+        d.replenishments -= before.replenishments;
+        d.consumptions -= before.consumptions;
+        d.consumed -= before.consumed;
+        for (int p = 0; p < SIM_PHASES; p++) d.cycles[p] -= before.cycles[p];
+        return d;
+    }
+};
+
+// Counters of every thread that simulated. They outlive their threads, so
+// the pool can be gone by the time they are merged.
+class CounterRegistry {
+private:
+    std::mutex lock;
+    std::deque<SimCounters> threads; // deque: adding a thread never moves another's counters
+
+public:
+    SimCounters& add() {
+        std::lock_guard<std::mutex> guard(lock);
+        threads.emplace_back();
+        return threads.back();
+    }
+
+    SimCounters total(int* count = nullptr) {
+        std::lock_guard<std::mutex> guard(lock);
+        SimCounters sum;
+        for (const SimCounters& c : threads) sum.add(c);
+        if (count) *count = threads.size();
+        return sum;
+    }
+};
+
+inline CounterRegistry& counterRegistry() {
+    static CounterRegistry registry;
+    return registry;
+}
+
+// The calling thread's counters
+inline SimCounters& threadCounters() {
+    thread_local SimCounters* mine = &counterRegistry().add();
+    return *mine;
+}
+
+// Every thread's counters merged; `threads` receives how many counted
+inline SimCounters allCounters(int* threads = nullptr) {
+    return counterRegistry().total(threads);
+}
+
+inline uint64_t cycleCount() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Charges the cycles between two marks to the phase the first one started
+class PhaseClock {
+private:
+    SimCounters& counters;
+    int phase = -1;
+    uint64_t since = 0;
+
+public:
+    PhaseClock(SimCounters& c) : counters(c) {}
+
+    void mark(int next) {
+        uint64_t now = cycleCount();
+        if (phase >= 0) counters.cycles[phase] += now - since;
+        phase = next;
+        since = now;
+    }
+    ~PhaseClock() { mark(-1); }
+};
+
+// The hooks of one simulation run. Without RTS_INSTRUMENT every member is
+// an empty inline function and the compiler drops the calls.
+#if RTS_INSTRUMENT
+class SimProbe {
+private:
+    SimCounters& counters;
+    const SimCounters before;
+    PhaseClock clock;
+    std::vector<Job*> running; // per core, while the job has work left
+
+public:
+    SimProbe(int cores = 1) : counters(threadCounters()), before(counters), clock(counters), running(cores, nullptr) {}
+
+    void phase(SimPhase p) { clock.mark(p); }
+    void count(uint64_t SimCounters::*field, uint64_t n = 1) { counters.*field += n; }
+
+    // `job` (null: idle) runs on `core` until the next event
+    void dispatch(int core, Job* job) {
+        Job*& last = running[core];
+        if (job == last) return;
+        if (job) counters.context_switches++;
+        if (last) counters.preemptions++;
+        last = job;
+    }
+    // `job` completed or missed its deadline: leaving its core preempts nothing
+    void left(Job* job) {
+        for (Job*& r : running) {
+            if (r == job) r = nullptr;
+        }
+    }
+
+    // What the run counted
+    SimCounters finish() {
+        clock.mark(-1);
+        return counters.since(before);
+    }
+};
+#else
+class SimProbe {
+public:
+    SimProbe(int = 1) {}
+    void phase(SimPhase) {}
+    void count(uint64_t SimCounters::*, uint64_t = 1) {}
+    void dispatch(int, Job*) {}
+    void left(Job*) {}
+    SimCounters finish() { return SimCounters(); }
+};
+#endif
+
+// A budget refill or charge inside a server scheduler
+inline void countBudget(uint64_t SimCounters::*field, uint64_t n = 1) {
+#if RTS_INSTRUMENT
+    threadCounters().*field += n;
+#else
+    (void)field;
+    (void)n;
+#endif
+}
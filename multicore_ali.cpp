@@ -0,0 +1,232 @@
+#include "sim_ali.cpp"
+#include <vector>
+#include <string>
+#include <numeric>
+
+using namespace std;
+
+// Multiprocessor runs on m identical cores, built on the uniprocessor
+// policies:
+//  - global: one ready queue for all cores; at each event the m best jobs
+//    (Scheduler::selectTasks) run, each preferably on the core it last ran
+//    on. Resuming on another core counts as a migration.
+//  - partitioned: tasks are bin-packed onto the cores by utilization and
+//    each core is an independent uniprocessor run of simulate().
+
+// Outcome of a global run, in addition to the scheduler's own counters
+struct MulticoreResult {
+    SimResult sim;
+    vector<vector<TraceRecord>> traces; // per core, run-length encoded
+    vector<Tick> busy;                  // time each core spent executing
+    long migrations = 0;
+};
+
+// Streams a finished trace record of `core`
+static void exportCore(TraceExport* trace_out, const TraceRecord& record, int core) {
+    const JobRecord& job = record.job;
+    trace_out->slice(record.start, record.end, job.seq, job.task_id, job.type, job.abs_deadline, core);
+}
+
+// One trace record per core switch, extended as time passes
+static void traceCore(vector<TraceRecord>& trace, Job* job, Tick now, int core, TraceExport* trace_out) {
+    long seq = job ? job->hook.seq : -1;
+    if (!trace.empty() && trace.back().job.seq == seq) return;
+    if (trace_out && !trace.empty()) exportCore(trace_out, trace.back(), core);
+    trace.push_back({now, now, recordOf(job)});
+}
+
+// Runs `sch` on m cores over [0, horizon.length). Only periodic and dynamic
+// tasks are released; `sch` must support global dispatch. Response times go
+// to `responses` as in simulate(). With `trace_out` set, the per-core
+// traces and the deadline misses are streamed to it as well.
+MulticoreResult simulateGlobal(Scheduler* sch, const vector<Task>& tasks, const SimHorizon& horizon, int m,
+                               ResponseRecorder* responses = nullptr, TraceExport* trace_out = nullptr) {
+    const Tick sim_length = horizon.length;
+    JobPool pool;
+    LiveJobs live(pool);
+    long released = 0;
+    sch->prepare(tasks);
+    if (responses) responses->reset(tasks.size());
+    if (trace_out) sch->exportTrace(trace_out);
+
+    TimerWheel timers;
+    vector<TimerNode> release_timers;
+    int one_shot = 0;
+    armReleases(timers, release_timers, tasks, false, one_shot);
+    DueTimers due;
+
+    MulticoreResult result;
+    result.traces.assign(m, vector<TraceRecord>());
+    result.busy.assign(m, 0);
+
+    Tick next_boundary = horizon.hyperperiod > 0 ? horizon.offset : NEVER;
+    StateHistory history;
+    vector<Tick> current;
+    vector<Job*> selected;
+    vector<Job*> on_core(m);
+    SimProbe probe(m);
+
+    while (sch->getCurrentTime() < sim_length) {
+        Tick current_time = sch->getCurrentTime();
+        probe.phase(PHASE_OTHER);
+
+        if (current_time >= next_boundary) {
+            // Also compare where every job last ran: it decides future migrations
+            stateSignature(sch, tasks, live.all(), current_time, current);
+            for (Job* job : live.all()) {
+                if (!job->isRetired()) current.push_back(job->core);
+            }
+            Tick seen = history.find(current);
+            if (seen >= 0) {
+                result.sim.repeat_from = seen;
+                break;
+            }
+            history.add(current_time, current);
+            next_boundary += horizon.hyperperiod;
+        }
+
+        probe.phase(PHASE_RELEASE);
+        due.collect(timers, current_time);
+        probe.count(&SimCounters::releases, due.releases.size());
+        for (TimerNode* timer : due.releases) {
+            const Task& task = tasks[timer->task];
+            Job* job = pool.create(&task, current_time, released++);
+            live.push(job);
+            armDeadline(timers, job);
+            sch->addReady(job);
+            timers.insert(timer, current_time + task.getP());
+        }
+        probe.phase(PHASE_MISS_CHECK);
+        probe.count(&SimCounters::deadline_checks);
+        for (TimerNode* timer : due.deadlines) {
+            Job* job = timer->job;
+            sch->addMissedDeadline(job);
+            sch->removeReady(job);
+            probe.left(job);
+            live.retire(job);
+        }
+        probe.phase(PHASE_SELECT);
+        Tick next_event = min(min(sim_length, next_boundary), timers.nextExpiry());
+
+        // Jobs stay on the core they last ran on when it is free; the rest
+        // take the free cores in order
+        selected.clear();
+        result.sim.events++;
+        probe.count(&SimCounters::selects);
+        sch->selectTasks(m, selected);
+        fill(on_core.begin(), on_core.end(), (Job*)NULL);
+        for (Job* job : selected) {
+            if (job->core >= 0 && !on_core[job->core]) on_core[job->core] = job;
+        }
+        int free_core = 0;
+        for (Job* job : selected) {
+            if (job->core >= 0 && on_core[job->core] == job) continue;
+            while (on_core[free_core]) free_core++;
+            if (job->core >= 0) result.migrations++;
+            job->core = free_core;
+            on_core[free_core] = job;
+        }
+
+        for (Job* job : selected) {
+            next_event = min(next_event, current_time + max<Tick>(1, job->getRem()));
+            next_event = min(next_event, sch->decisionHorizon(job));
+        }
+        Tick dt = next_event - current_time;
+        for (int c = 0; c < m; c++) probe.dispatch(c, on_core[c]);
+        probe.phase(PHASE_EXECUTE);
+        for (int c = 0; c < m; c++) {
+            Job* job = on_core[c];
+            traceCore(result.traces[c], job, current_time, c, trace_out);
+            if (!job) continue;
+            sch->execute_server_version(job, dt);
+            result.busy[c] += dt;
+            if (job->isComplete()) {
+                if (responses) responses->record(job->getTask() - tasks.data(), next_event - job->getJobReleaseTime());
+                sch->removeReady(job);
+                sch->addFinishedJob(job);
+                timers.remove(&job->deadline_timer);
+                probe.left(job);
+                live.retire(job);
+            }
+        }
+        sch->clockTick(dt);
+        for (auto& trace : result.traces) trace.back().end = sch->getCurrentTime();
+    }
+
+    if (trace_out) {
+        for (int c = 0; c < m; c++) {
+            if (!result.traces[c].empty()) exportCore(trace_out, result.traces[c].back(), c);
+        }
+        sch->finishTrace();
+    }
+
+    result.sim.end = sch->getCurrentTime();
+    result.sim.released = released;
+    result.sim.counters = probe.finish();
+    return result;
+}
+
+enum PackingHeuristic { FIRST_FIT, BEST_FIT, WORST_FIT };
+
+const char* packingName(PackingHeuristic h) {
+    switch (h) {
+        case BEST_FIT: return "best-fit decreasing";
+        case WORST_FIT: return "worst-fit decreasing";
+        default: return "first-fit decreasing";
+    }
+}
+
+double taskUtilization(const Task& task) {
+    if (task.getType() == Aperiodic || task.getP() <= 0) return 0;
+    return (double)max<Tick>(task.getE(), 1) / task.getP();
+}
+
+// Whether a core already holding `count` tasks of utilization `load` still
+// passes the policy's utilization test with one more task of utilization u:
+// U <= 1 for EDF and LLF, the Liu & Layland bound for the fixed-priority
+// policies
+static bool fitsOnCore(const string& policy, double load, int count, double u) {
+    if (policy == "EDF" || policy == "LLF") return load + u <= 1.0 + 1e-9;
+    double n = count + 1;
+    return load + u <= n * (pow(2.0, 1.0 / n) - 1) + 1e-9;
+}
+
+// Assigns every periodic and dynamic task to one of m cores, taking tasks
+// by decreasing utilization and placing each with heuristic h. Aperiodic
+// tasks are left out. Returns the indices of the tasks that fit nowhere.
+vector<size_t> partitionTasks(const vector<Task>& tasks, int m, const string& policy, PackingHeuristic h,
+                              vector<vector<size_t>>& cores, vector<double>& load) {
+    cores.assign(m, vector<size_t>());
+    load.assign(m, 0);
+    vector<size_t> order;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        if (tasks[i].getType() != Aperiodic && tasks[i].getP() > 0) order.push_back(i);
+    }
+    // Stable, so equal utilizations keep their input order
+    stable_sort(order.begin(), order.end(),
+                [&](size_t a, size_t b) { return taskUtilization(tasks[a]) > taskUtilization(tasks[b]); });
+
+    vector<size_t> unplaced;
+    for (size_t i : order) {
+        double u = taskUtilization(tasks[i]);
+        int chosen = -1;
+        for (int c = 0; c < m; c++) {
+            if (!fitsOnCore(policy, load[c], cores[c].size(), u)) continue;
+            if (chosen < 0 || h == FIRST_FIT) {
+                chosen = c;
+                if (h == FIRST_FIT) break;
+            } else if (h == BEST_FIT ? load[c] > load[chosen] : load[c] < load[chosen]) {
+                chosen = c;
+            }
+        }
+        if (chosen < 0) {
+            unplaced.push_back(i);
+            continue;
+        }
+        cores[chosen].push_back(i);
+        load[chosen] += u;
+    }
+    // Keep each core's tasks in input order, which is the release order at equal times
+    for (auto& core : cores) sort(core.begin(), core.end());
+    return unplaced;
+}
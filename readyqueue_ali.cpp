@@ -0,0 +1,213 @@
+#include "task_ali.cpp"
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// Persistent ready-queue structures owned by the schedulers.
+// Jobs carry their own slot (Job::hook) so removal never has to search.
+//
+// Selection never scans the ready jobs. A structure-of-arrays ready set
+// with SIMD arg-min kernels (deadline, period and slack columns) once served
+// LLF and the servers, but a 10k-job pick still took 4.5 us with AVX2
+// against the O(1) peek of the heaps and FIFOs that replaced it. Keeping the
+// heap's keys in columns beside the jobs does not pay either: every move
+// still writes the job's hook.pos, so it only adds copies (27 against 18 ns
+// per requeue with 8 jobs, 117 against 62 ns with 4096).
+
+// Binary min-heap of jobs. `Before(a, b)` must be a strict order; ties are
+// broken on release order so equal keys are served first come first served,
+// exactly like the linear scans this replaces.
+template <class Before>
+class JobHeap {
+private:
+    std::vector<Job*> heap;
+    Before before;
+
+    bool less(Job* a, Job* b) {
+        if (before(a, b)) return true;
+        if (before(b, a)) return false;
+        return a->hook.seq < b->hook.seq;
+    }
+    void place(int i, Job* job) {
+        heap[i] = job;
+        job->hook.pos = i;
+    }
+    void siftUp(int i) {
+        Job* job = heap[i];
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!less(job, heap[parent])) break;
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, job);
+    }
+    void siftDown(int i) {
+        Job* job = heap[i];
+        int n = heap.size();
+        while (true) {
+            int child = 2 * i + 1;
+            if (child >= n) break;
+            if (child + 1 < n && less(heap[child + 1], heap[child])) child++;
+            if (!less(heap[child], job)) break;
+            place(i, heap[child]);
+            i = child;
+        }
+        place(i, job);
+    }
+
+public:
+    JobHeap(Before b = Before()) : before(b) {}
+
+    bool empty() { return heap.empty(); }
+    int size() { return heap.size(); }
+    Job* top() { return heap.empty() ? NULL : heap.front(); }
+    // Job that would be on top if the current top left
+    Job* second() {
+        if (heap.size() < 2) return NULL;
+        if (heap.size() == 2 || less(heap[1], heap[2])) return heap[1];
+        return heap[2];
+    }
+
+    void push(Job* job) {
+        heap.push_back(job);
+        siftUp(heap.size() - 1);
+    }
+
+    void remove(Job* job) {
+        int i = job->hook.pos;
+        Job* last = heap.back();
+        heap.pop_back();
+        job->hook.pos = -1;
+        if (last == job) return;
+        place(i, last);
+        siftDown(i);
+        siftUp(last->hook.pos);
+    }
+
+    // Restores the heap order after job's key changed
+    void update(Job* job) {
+        siftDown(job->hook.pos);
+        siftUp(job->hook.pos);
+    }
+
+    void clear() {
+        for (Job* job : heap) job->hook.pos = -1;
+        heap.clear();
+    }
+
+    // Every queued job, in no particular order
+    const std::vector<Job*>& jobs() { return heap; }
+    // Restores the heap order after any number of keys changed
+    void rebuild() {
+        for (int i = (int)heap.size() / 2 - 1; i >= 0; i--) siftDown(i);
+    }
+
+    // Appends the first m jobs in priority order. Expands the heap from the
+    // root through a small frontier heap, so it costs O(m log m).
+    void topN(int m, std::vector<Job*>& out) {
+        int n = heap.size();
+        if (n == 0 || m <= 0) return;
+        auto later = [this](int a, int b) { return less(heap[b], heap[a]); };
+        std::vector<int> frontier(1, 0);
+        while (!frontier.empty() && m-- > 0) {
+            std::pop_heap(frontier.begin(), frontier.end(), later);
+            int i = frontier.back();
+            frontier.pop_back();
+            out.push_back(heap[i]);
+            for (int child = 2 * i + 1; child <= 2 * i + 2 && child < n; child++) {
+                frontier.push_back(child);
+                std::push_heap(frontier.begin(), frontier.end(), later);
+            }
+        }
+    }
+};
+
+// Intrusive first-come-first-served queue linked through hook.prev/next:
+// push, remove and front are O(1) and never allocate. Jobs must be pushed in
+// release order for front() to be the first released.
+class JobFifo {
+private:
+    Job* head = NULL;
+    Job* tail = NULL;
+
+public:
+    bool empty() { return head == NULL; }
+    Job* front() { return head; }
+
+    void push(Job* job) {
+        job->hook.prev = tail;
+        job->hook.next = NULL;
+        if (tail) tail->hook.next = job;
+        else head = job;
+        tail = job;
+    }
+
+    void remove(Job* job) {
+        if (job->hook.prev) job->hook.prev->hook.next = job->hook.next;
+        else head = job->hook.next;
+        if (job->hook.next) job->hook.next->hook.prev = job->hook.prev;
+        else tail = job->hook.prev;
+        job->hook.prev = job->hook.next = NULL;
+    }
+};
+
+// Fixed-priority bucket queue: one FIFO per priority level plus a bitmap of
+// non-empty levels. Level 0 is the highest priority. Insert and remove are
+// O(1); peeking is O(1) because the highest non-empty level is cached and
+// only recomputed (by scanning the bitmap) when that level drains.
+class PriorityBuckets {
+private:
+    std::vector<JobFifo> buckets;
+    std::vector<uint64_t> bitmap;
+    int highest = -1;
+    int count = 0;
+
+    // First non-empty level at or below `from` in priority, or -1
+    int nextLevel(int from) {
+        for (size_t w = from / 64; w < bitmap.size(); w++) {
+            uint64_t bits = bitmap[w];
+            if (w == (size_t)from / 64) bits &= ~0ULL << (from % 64);
+            if (bits) return w * 64 + __builtin_ctzll(bits);
+        }
+        return -1;
+    }
+
+public:
+    void setLevels(int levels) {
+        buckets.assign(levels, JobFifo());
+        bitmap.assign((levels + 63) / 64, 0);
+        highest = -1;
+        count = 0;
+    }
+
+    bool empty() { return count == 0; }
+    int size() { return count; }
+    Job* top() { return highest < 0 ? NULL : buckets[highest].front(); }
+
+    // Appends the first m jobs in priority order
+    void topN(int m, std::vector<Job*>& out) {
+        for (int level = highest; level >= 0 && m > 0; level = nextLevel(level + 1)) {
+            for (Job* job = buckets[level].front(); job && m > 0; job = job->hook.next, m--) out.push_back(job);
+        }
+    }
+
+    void push(Job* job, int level) {
+        job->hook.pos = level;
+        buckets[level].push(job);
+        bitmap[level / 64] |= 1ULL << (level % 64);
+        if (highest < 0 || level < highest) highest = level;
+        count++;
+    }
+
+    void remove(Job* job) {
+        int level = job->hook.pos;
+        buckets[level].remove(job);
+        job->hook.pos = -1;
+        count--;
+        if (buckets[level].empty()) {
+            bitmap[level / 64] &= ~(1ULL << (level % 64));
+            if (level == highest) highest = nextLevel(level);
+        }
+    }
+};
@@ -0,0 +1,418 @@
+#include <vector>
+#include <string>
+#include <memory>
+#include <charconv>
+#include <cmath>
+#include <ostream>
+#include <fstream>
+
+// Schedule reports. A run hands its schedule to a Reporter: the
+// human-readable text on the run's output, or CSV / JSON lines for the
+// --report file. Reporters format into an OutBuffer, which converts numbers
+// with std::to_chars and hands the stream large blocks instead of flushing
+// it on every line.
+
+// Large append-only text buffer in front of an ostream
+class OutBuffer {
+private:
+    static const size_t FLUSH_AT = 1 << 16;
+    std::ostream& out;
+    std::string buffer;
+
+    void reserveFor(size_t n) {
+        if (buffer.size() + n > FLUSH_AT) flush();
+    }
+    template <class... Format>
+    void convert(double value, Format... format) {
+        char digits[64];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value, format...);
+        buffer.append(digits, result.ptr);
+    }
+
+public:
+    explicit OutBuffer(std::ostream& o) : out(o) { buffer.reserve(FLUSH_AT + 256); }
+    OutBuffer(const OutBuffer&) = delete;
+    OutBuffer& operator=(const OutBuffer&) = delete;
+    ~OutBuffer() { flush(); }
+
+    void flush() {
+        if (buffer.empty()) return;
+        out.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+
+    OutBuffer& put(char c) {
+        reserveFor(1);
+        buffer.push_back(c);
+        return *this;
+    }
+    OutBuffer& put(const char* s) { return put(std::string_view(s)); }
+    OutBuffer& put(std::string_view s) {
+        reserveFor(s.size());
+        buffer.append(s);
+        return *this;
+    }
+    OutBuffer& integer(long long value) {
+        reserveFor(24);
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, result.ptr);
+        return *this;
+    }
+    // Like an ostream at precision 15 (%.15g)
+    OutBuffer& number(double value) {
+        reserveFor(64);
+        convert(value, std::chars_format::general, 15);
+        return *this;
+    }
+    // Like std::fixed at `digits` (%.Nf)
+    OutBuffer& fixed(double value, int digits) {
+        reserveFor(64);
+        convert(value, std::chars_format::fixed, digits);
+        return *this;
+    }
+    // `t` ticks in time units, as number() prints them
+    OutBuffer& units(Tick t, Tick resolution) {
+        if (resolution == 1 && t > -1000000000000000LL && t < 1000000000000000LL) return integer(t);
+        return number((double)t / resolution);
+    }
+    // JSON string literal
+    OutBuffer& quoted(std::string_view s) {
+        put('"');
+        for (char c : s) {
+            if (c == '"' || c == '\\') put('\\');
+            put(c);
+        }
+        return put('"');
+    }
+};
+
+// The instrumentation counters of a run (or of all of them), two lines
+inline void writeCounters(OutBuffer& out, const SimCounters& c) {
+    out.put("Counters: selects ").integer(c.selects).put(", context switches ").integer(c.context_switches);
+    out.put(", preemptions ").integer(c.preemptions).put(", releases ").integer(c.releases);
+    out.put(", deadline checks ").integer(c.deadline_checks).put(", replenishments ").integer(c.replenishments);
+    out.put(", budget consumptions ").integer(c.consumptions).put(" (").integer(c.consumed).put(" ticks)\n");
+    out.put("Phase cycles:");
+    for (int p = 0; p < SIM_PHASES; p++) out.put(p ? ", " : " ").put(SIM_PHASE_NAMES[p]).put(' ').integer(c.cycles[p]);
+    out.put('\n');
+}
+
+// End of a run's schedule
+struct RunSummary {
+    long completed = 0;
+    Span<JobRecord> missed;
+    SimResult result{};
+    bool until = false;     // report how far the run went
+    long migrations = -1;   // multiprocessor runs only, with busy and ends per core
+    std::vector<Tick> busy, ends;
+    bool switching = false; // report preemptions and switch overhead
+    long preemptive = -1;   // ... and those of the fully preemptive run, if compared
+    bool criticality = false; // report mode switches and dropped jobs
+    bool energy = false;      // report the energy, against full_energy at full speed
+    double full_energy = 0;
+
+    RunSummary(long completed, Span<JobRecord> missed) : completed(completed), missed(missed) {}
+};
+
+// Receives one run's schedule at a time: begin(), then every entry in start
+// order unless the reporter is summary-only, then summary().
+class Reporter {
+protected:
+    const bool summary_only; // the schedule lines are left out
+
+public:
+    Reporter(bool summary_only) : summary_only(summary_only) {}
+    virtual ~Reporter() {}
+
+    virtual bool wantsEntries() const { return !summary_only; }
+
+    // `cores` > 1 for a global multiprocessor run, whose entries name their
+    // core; `core` >= 0 for the uniprocessor run of one partitioned core
+    virtual void begin(const std::string& scheduler, Tick resolution, int cores = 1, int core = -1) = 0;
+    // `job` (idle if seq < 0) starts running at `time`
+    virtual void entry(Tick time, const JobRecord& job, int core) = 0;
+    virtual void summary(const RunSummary& summary) = 0;
+};
+
+inline const char* typeSuffix(TaskTypes type) {
+    return type == Periodic ? "(P)" : type == Dynamic ? "(D)" : "(A)";
+}
+
+// The schedule as printed on the console
+class TextReporter : public Reporter {
+private:
+    OutBuffer out;
+    Tick resolution = 1;
+
+public:
+    TextReporter(std::ostream& o, bool summary_only = false) : Reporter(summary_only), out(o) {}
+
+    void begin(const std::string& scheduler, Tick res, int cores, int) override {
+        resolution = res;
+        out.put("\n=== ").put(scheduler).put(" Scheduling");
+        if (cores > 1) out.put(" (").integer(cores).put(" cores)");
+        out.put(" ===\n");
+        if (summary_only) return;
+        if (cores > 1) out.put("Time\tCore\tTask\tAction\n----\t----\t----\t------\n");
+        else out.put("Time\tTask\tAction\n----\t----\t------\n");
+    }
+
+    void entry(Tick time, const JobRecord& job, int core) override {
+        out.units(time, resolution);
+        if (core >= 0) out.put('\t').integer(core);
+        if (job.seq < 0) {
+            out.put("\tIDLE\t-\n");
+            return;
+        }
+        out.put("\tT").integer(job.task_id).put(typeSuffix(job.type)).put("\tExecuting (deadline: ");
+        if (job.type == Aperiodic) out.put("N/A");
+        else out.fixed((double)job.abs_deadline / resolution, 2);
+        out.put(")\n");
+    }
+
+    void summary(const RunSummary& s) override {
+        out.put("\nSummary:\nCompleted jobs: ").integer(s.completed).put('\n');
+        out.put("Missed deadlines: ").integer(s.missed.size()).put('\n');
+        if (!s.missed.empty()) {
+            out.put("Deadline misses for tasks: ");
+            for (const auto& job : s.missed) out.put('T').integer(job.task_id).put(" at t=").units(job.abs_deadline, resolution).put(' ');
+            out.put('\n');
+        }
+        if (s.switching) {
+            out.put("Preemptions: ").integer(s.result.preemptions);
+            if (s.preemptive >= 0) {
+                out.put(" (fully preemptive: ").integer(s.preemptive);
+                out.put(", avoided: ").integer(s.preemptive - s.result.preemptions).put(')');
+            }
+            out.put("\nContext switches: ").integer(s.result.switches);
+            out.put(", overhead: ").units(s.result.overhead, resolution).put('\n');
+        }
+        if (s.criticality) {
+            out.put("Criticality mode switches: ").integer(s.result.mode_switches);
+            out.put(", LO jobs dropped: ").integer(s.result.dropped).put('\n');
+        }
+        if (s.energy) {
+            out.put("Energy: ").number(s.result.energy / resolution);
+            out.put(" (at full speed: ").number(s.full_energy / resolution);
+            double saved = s.full_energy > 0 ? 100 * (1 - s.result.energy / s.full_energy) : 0;
+            if (std::fabs(saved) < 0.05) saved = 0; // no "-0.0"
+            out.put(", saved: ").fixed(saved, 1).put("%)\n");
+        }
+        if (s.migrations >= 0) {
+            out.put("Migrations: ").integer(s.migrations).put('\n');
+            out.put("Core utilization:");
+            for (size_t c = 0; c < s.busy.size(); c++) {
+                out.put(' ').integer(c).put(": ").number(s.ends[c] > 0 ? (double)s.busy[c] / s.ends[c] : 0);
+            }
+            out.put('\n');
+        }
+        if (s.until) {
+            out.put("Simulated until: ").units(s.result.end, resolution);
+            if (s.result.repeat_from >= 0) out.put(" (schedule repeats from t=").units(s.result.repeat_from, resolution).put(')');
+            out.put('\n');
+        }
+        if (RTS_INSTRUMENT) writeCounters(out, s.result.counters);
+        out.put('\n');
+        // The run's other output continues on the stream itself
+        out.flush();
+    }
+};
+
+// Machine-readable reports: one record per schedule entry ("start" of a job,
+// "idle"), per deadline miss ("miss") and per run ("summary"), labelled with
+// the input file, the 1-based set and the scheduler. Times are in time units.
+class RecordReporter : public Reporter {
+protected:
+    OutBuffer out;
+    const std::string file;
+    const int set;
+    std::string scheduler;
+    Tick resolution = 1;
+    int run_core = -1;
+
+public:
+    RecordReporter(std::ostream& o, const std::string& file, int set, bool summary_only)
+        : Reporter(summary_only), out(o), file(file), set(set) {}
+
+    void begin(const std::string& name, Tick res, int, int core) override {
+        scheduler = name;
+        resolution = res;
+        run_core = core;
+    }
+};
+
+// CSV, one row per record; see CSV_REPORT_HEADER for the columns, which are
+// left empty where they do not apply
+const char* const CSV_REPORT_HEADER =
+    "file,set,scheduler,event,time,core,task,type,deadline,completed,missed,end,repeat_from,migrations\n";
+
+class CsvReporter : public RecordReporter {
+private:
+    void label(const char* event) {
+        out.put(file).put(',').integer(set + 1).put(',').put(scheduler).put(',').put(event).put(',');
+    }
+    void job(const JobRecord& job) {
+        out.integer(job.task_id).put(',').put(std::string_view(typeSuffix(job.type) + 1, 1)).put(',');
+        if (job.type != Aperiodic) out.units(job.abs_deadline, resolution);
+    }
+
+public:
+    using RecordReporter::RecordReporter;
+
+    void entry(Tick time, const JobRecord& job, int core) override {
+        label(job.seq < 0 ? "idle" : "start");
+        out.units(time, resolution).put(',');
+        if (core < 0) core = run_core;
+        if (core >= 0) out.integer(core);
+        out.put(',');
+        if (job.seq >= 0) this->job(job);
+        else out.put(",,");
+        out.put(",,,,,\n");
+    }
+
+    void summary(const RunSummary& s) override {
+        for (const auto& missed : s.missed) {
+            label("miss");
+            out.units(missed.abs_deadline, resolution).put(',');
+            if (run_core >= 0) out.integer(run_core);
+            out.put(',');
+            job(missed);
+            out.put(",,,,,\n");
+        }
+        label("summary");
+        out.put(",");
+        if (run_core >= 0) out.integer(run_core);
+        out.put(",,,,").integer(s.completed).put(',').integer(s.missed.size()).put(',');
+        out.units(s.result.end, resolution).put(',');
+        if (s.result.repeat_from >= 0) out.units(s.result.repeat_from, resolution);
+        out.put(',');
+        if (s.migrations >= 0) out.integer(s.migrations);
+        out.put('\n');
+    }
+};
+
+// JSON lines: one object per record, without the fields that do not apply
+class JsonLinesReporter : public RecordReporter {
+private:
+    void label(const char* event) {
+        out.put("{\"file\": ").quoted(file).put(", \"set\": ").integer(set + 1);
+        out.put(", \"scheduler\": ").quoted(scheduler).put(", \"event\": \"").put(event).put('"');
+    }
+    void core(int c) {
+        if (c < 0) c = run_core;
+        if (c >= 0) out.put(", \"core\": ").integer(c);
+    }
+    void counters(const SimCounters& c) {
+        const std::pair<const char*, uint64_t> fields[] = {
+            {"selects", c.selects}, {"context_switches", c.context_switches}, {"preemptions", c.preemptions},
+            {"releases", c.releases}, {"deadline_checks", c.deadline_checks}, {"replenishments", c.replenishments},
+            {"consumptions", c.consumptions}, {"consumed", c.consumed}};
+        out.put(", \"counters\": {");
+        for (size_t k = 0; k < 8; k++) out.put(k ? ", \"" : "\"").put(fields[k].first).put("\": ").integer(fields[k].second);
+        out.put("}, \"cycles\": {");
+        for (int p = 0; p < SIM_PHASES; p++) out.put(p ? ", \"" : "\"").put(SIM_PHASE_NAMES[p]).put("\": ").integer(c.cycles[p]);
+        out.put('}');
+    }
+    void job(const JobRecord& job) {
+        out.put(", \"task\": ").integer(job.task_id).put(", \"type\": \"").put(std::string_view(typeSuffix(job.type) + 1, 1)).put('"');
+        if (job.type != Aperiodic) out.put(", \"deadline\": ").units(job.abs_deadline, resolution);
+    }
+
+public:
+    using RecordReporter::RecordReporter;
+
+    void entry(Tick time, const JobRecord& job, int c) override {
+        label(job.seq < 0 ? "idle" : "start");
+        out.put(", \"time\": ").units(time, resolution);
+        core(c);
+        if (job.seq >= 0) this->job(job);
+        out.put("}\n");
+    }
+
+    void summary(const RunSummary& s) override {
+        for (const auto& missed : s.missed) {
+            label("miss");
+            out.put(", \"time\": ").units(missed.abs_deadline, resolution);
+            core(-1);
+            job(missed);
+            out.put("}\n");
+        }
+        label("summary");
+        core(-1);
+        out.put(", \"completed\": ").integer(s.completed).put(", \"missed\": ").integer(s.missed.size());
+        out.put(", \"end\": ").units(s.result.end, resolution);
+        if (s.result.repeat_from >= 0) out.put(", \"repeat_from\": ").units(s.result.repeat_from, resolution);
+        if (s.migrations >= 0) out.put(", \"migrations\": ").integer(s.migrations);
+        if (s.switching) {
+            out.put(", \"preemptions\": ").integer(s.result.preemptions);
+            if (s.preemptive >= 0) out.put(", \"fully_preemptive\": ").integer(s.preemptive);
+            out.put(", \"switches\": ").integer(s.result.switches);
+            out.put(", \"overhead\": ").units(s.result.overhead, resolution);
+        }
+        if (s.criticality) {
+            out.put(", \"mode_switches\": ").integer(s.result.mode_switches);
+            out.put(", \"dropped\": ").integer(s.result.dropped);
+        }
+        if (s.energy) {
+            out.put(", \"energy\": ").number(s.result.energy / resolution);
+            out.put(", \"energy_full_speed\": ").number(s.full_energy / resolution);
+        }
+        if (RTS_INSTRUMENT) counters(s.result.counters);
+        out.put("}\n");
+    }
+};
+
+enum ReportFormat { REPORT_CSV, REPORT_JSONL };
+
+// The --report file. Each task set gets its own reporter; those of parallel
+// runs write into buffers that are appended in input order.
+class ReportFile {
+private:
+    std::ofstream out;
+    const ReportFormat format;
+    const bool summary_only;
+
+public:
+    ReportFile(const std::string& filename, ReportFormat format, bool summary_only)
+        : out(filename), format(format), summary_only(summary_only) {
+        if (format == REPORT_CSV) out << CSV_REPORT_HEADER;
+    }
+
+    bool good() const { return (bool)out; }
+
+    // Reporter for set `set` of `file`, writing to `to` or else to the file
+    std::unique_ptr<Reporter> reporter(const std::string& file, int set, std::ostream* to = nullptr) {
+        std::ostream& o = to ? *to : out;
+        if (format == REPORT_JSONL) return std::unique_ptr<Reporter>(new JsonLinesReporter(o, file, set, summary_only));
+        return std::unique_ptr<Reporter>(new CsvReporter(o, file, set, summary_only));
+    }
+
+    void write(const std::string& records) { out << records; }
+};
+
+// Passes a run's schedule to the run's text report and, with --report, to
+// the set's record reporter as well
+class ReportTee : public Reporter {
+private:
+    Reporter& first;
+    Reporter* second;
+
+public:
+    ReportTee(Reporter& a, Reporter* b) : Reporter(false), first(a), second(b) {}
+
+    bool wantsEntries() const override { return first.wantsEntries() || (second && second->wantsEntries()); }
+
+    void begin(const std::string& scheduler, Tick resolution, int cores, int core) override {
+        first.begin(scheduler, resolution, cores, core);
+        if (second) second->begin(scheduler, resolution, cores, core);
+    }
+    void entry(Tick time, const JobRecord& job, int core) override {
+        if (first.wantsEntries()) first.entry(time, job, core);
+        if (second && second->wantsEntries()) second->entry(time, job, core);
+    }
+    void summary(const RunSummary& summary) override {
+        first.summary(summary);
+        if (second) second->summary(summary);
+    }
+};
@@ -0,0 +1,194 @@
+#include "rts_batch.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Takes over an already mapped file; same results as batch_open
+static int batch_attach(const char *filename, Batch *batch) {
+    const char *data = batch->file.data;
+    size_t length = batch->file.length;
+    BatchHeader header;
+    if (length < sizeof(header) || memcmp(data, BATCH_MAGIC, 8) != 0) return 1;
+    memcpy(&header, data, sizeof(header));
+    if (header.version != BATCH_VERSION) {
+        fprintf(stderr, "Error: '%s' is a batch of version %u (expected %d, or written with another byte order)\n",
+                filename, header.version, BATCH_VERSION);
+        return -1;
+    }
+    if (header.index_offset % sizeof(uint64_t) != 0 || header.index_offset > length ||
+        (length - header.index_offset) / sizeof(uint64_t) < header.set_count) {
+        fprintf(stderr, "Error: '%s' has a corrupt set index\n", filename);
+        return -1;
+    }
+    batch->set_count = header.set_count;
+    batch->index = (const uint64_t *)(data + header.index_offset);
+    return 0;
+}
+
+int batch_open(const char *filename, Batch *batch) {
+    if (map_file(filename, &batch->file) < 0) return -1;
+    int status = batch_attach(filename, batch);
+    if (status != 0) unmap_file(&batch->file);
+    return status;
+}
+
+void batch_close(Batch *batch) {
+    unmap_file(&batch->file);
+    batch->set_count = 0;
+    batch->index = NULL;
+}
+
+int batch_load(const Batch *batch, uint32_t n, ParserState *state) {
+    const char *data = batch->file.data;
+    size_t length = batch->file.length;
+    BatchSetRecord set;
+    if (n >= batch->set_count) return -1;
+    uint64_t offset = batch->index[n];
+    if (offset > length || length - offset < sizeof(set)) return -1;
+    memcpy(&set, data + offset, sizeof(set));
+    const char *records = data + offset + sizeof(set);
+    if (set.task_count < 0 ||
+        (size_t)(data + length - records) / sizeof(BatchTaskRecord) < (size_t)set.task_count) {
+        return -1;
+    }
+
+    if (set.task_count > state->task_capacity) {
+        ParsedTask *tasks = realloc(state->tasks, (size_t)set.task_count * sizeof(ParsedTask));
+        if (tasks == NULL) return -1;
+        state->tasks = tasks;
+        state->task_capacity = set.task_count;
+    }
+    for (int i = 0; i < set.task_count; i++) {
+        BatchTaskRecord r;
+        memcpy(&r, records + i * sizeof(r), sizeof(r));
+        ParsedTask *t = &state->tasks[i];
+        t->type = (ParsedTaskType)r.type;
+        t->release_time = r.release_time;
+        t->execution_time = r.execution_time;
+        t->period = r.period;
+        t->deadline = r.deadline;
+        t->criticality = (ParsedCriticality)r.criticality;
+        t->execution_time_hi = r.execution_time_hi;
+    }
+    state->task_count = set.task_count;
+    state->server.type = (ParsedServerType)set.server_type;
+    state->server.budget = set.server_budget;
+    state->server.period = set.server_period;
+    state->server.scheduling = (ParsedSchedulingType)set.server_scheduling;
+    return 0;
+}
+
+static int write_bytes(BatchWriter *writer, const void *bytes, size_t n) {
+    if (fwrite(bytes, 1, n, writer->file) != n) return -1;
+    writer->position += n;
+    return 0;
+}
+
+int batch_writer_open(BatchWriter *writer, const char *filename) {
+    writer->file = fopen(filename, "wb");
+    writer->offsets = NULL;
+    writer->count = 0;
+    writer->capacity = 0;
+    writer->position = 0;
+    if (writer->file == NULL) {
+        fprintf(stderr, "Error: Cannot create file '%s'\n", filename);
+        return -1;
+    }
+    // Placeholder, rewritten once the index position is known
+    BatchHeader header;
+    memset(&header, 0, sizeof(header));
+    return write_bytes(writer, &header, sizeof(header));
+}
+
+int batch_write_set(BatchWriter *writer, const ParserState *state) {
+    if (writer->count == writer->capacity) {
+        uint32_t capacity = writer->capacity ? 2 * writer->capacity : 64;
+        uint64_t *offsets = realloc(writer->offsets, capacity * sizeof(uint64_t));
+        if (offsets == NULL) return -1;
+        writer->offsets = offsets;
+        writer->capacity = capacity;
+    }
+    writer->offsets[writer->count++] = writer->position;
+
+    BatchSetRecord set = {state->task_count, state->server.type, state->server.budget,
+                          state->server.period, state->server.scheduling, 0};
+    if (write_bytes(writer, &set, sizeof(set)) < 0) return -1;
+    for (int i = 0; i < state->task_count; i++) {
+        const ParsedTask *t = &state->tasks[i];
+        BatchTaskRecord r = {t->type, t->release_time, t->execution_time, t->period,
+                             t->deadline, t->criticality, t->execution_time_hi};
+        if (write_bytes(writer, &r, sizeof(r)) < 0) return -1;
+    }
+    return 0;
+}
+
+int batch_writer_close(BatchWriter *writer) {
+    int status = 0;
+    // Align the index so it can be read in place
+    static const char padding[sizeof(uint64_t)] = {0};
+    size_t pad = (sizeof(uint64_t) - writer->position % sizeof(uint64_t)) % sizeof(uint64_t);
+    if (write_bytes(writer, padding, pad) < 0) status = -1;
+
+    BatchHeader header;
+    memcpy(header.magic, BATCH_MAGIC, 8);
+    header.version = BATCH_VERSION;
+    header.set_count = writer->count;
+    header.index_offset = writer->position;
+    if (status == 0 && writer->count > 0 &&
+        write_bytes(writer, writer->offsets, writer->count * sizeof(uint64_t)) < 0) {
+        status = -1;
+    }
+    if (status == 0 && (fseek(writer->file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, writer->file) != 1)) {
+        status = -1;
+    }
+    if (fclose(writer->file) != 0) status = -1;
+    free(writer->offsets);
+    writer->file = NULL;
+    writer->offsets = NULL;
+    return status;
+}
+
+// Text files: forwards only the requested range of sets
+typedef struct {
+    int first;
+    int count;
+    int delivered;
+    ParseSetCallback callback;
+    void *user;
+} SetRange;
+
+static int forward_in_range(ParserState *state, int set_index, void *user) {
+    SetRange *range = (SetRange *)user;
+    if (set_index < range->first) return 0;
+    range->delivered++;
+    if (range->callback(state, set_index, range->user)) return 1;
+    return range->count >= 0 && range->delivered >= range->count;
+}
+
+int load_sets(const char *filename, int first, int count, ParseSetCallback callback, void *user) {
+    // Mapped once: the input may be a pipe that cannot be read twice
+    Batch batch;
+    if (map_file(filename, &batch.file) < 0) return -1;
+    int status = batch_attach(filename, &batch);
+    if (status != 0) {
+        SetRange range = {first, count, 0, callback, user};
+        if (status > 0 && parse_mapped(&batch.file, filename, forward_in_range, &range) < 0) status = -1;
+        unmap_file(&batch.file);
+        return status < 0 ? -1 : range.delivered;
+    }
+
+    ParserState state;
+    init_parser_state(&state);
+    int delivered = 0;
+    for (uint32_t n = first; n < batch.set_count && (count < 0 || delivered < count); n++) {
+        if (batch_load(&batch, n, &state) < 0) {
+            fprintf(stderr, "Error: '%s' has a corrupt set %u\n", filename, n + 1);
+            delivered = -1;
+            break;
+        }
+        delivered++;
+        if (callback(&state, n, user)) break;
+    }
+    free_parser_state(&state);
+    batch_close(&batch);
+    return delivered;
+}
@@ -0,0 +1,90 @@
+#ifndef RTS_BATCH_H
+#define RTS_BATCH_H
+
+#include "rts_parser.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Binary batch of task sets, written by rts_pack from text files and read
+// back without any text parsing. Layout:
+//
+//   BatchHeader
+//   for each set: BatchSetRecord, then task_count BatchTaskRecords
+//   index: set_count uint64_t file offsets of the BatchSetRecords
+//
+// All fields are fixed-width integers in the byte order of the machine that
+// wrote the file; the version field doubles as a byte-order check.
+
+#define BATCH_MAGIC "RTSBATCH"
+#define BATCH_VERSION 2
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t set_count;
+    uint64_t index_offset;
+} BatchHeader;
+
+typedef struct {
+    int32_t task_count;
+    int32_t server_type;        // ParsedServerType
+    int32_t server_budget;
+    int32_t server_period;
+    int32_t server_scheduling;  // ParsedSchedulingType
+    int32_t reserved;
+} BatchSetRecord;
+
+typedef struct {
+    int32_t type;               // ParsedTaskType
+    int32_t release_time;
+    int32_t execution_time;
+    int32_t period;
+    int32_t deadline;
+    int32_t criticality;        // ParsedCriticality
+    int32_t execution_time_hi;
+} BatchTaskRecord;
+
+// An open (mapped) batch file
+typedef struct {
+    MappedFile file;
+    uint32_t set_count;
+    const uint64_t *index;
+} Batch;
+
+// Opens a batch file. Returns 0 on success, 1 if the file is not a batch
+// (e.g. a text task file) and -1 on error.
+int batch_open(const char *filename, Batch *batch);
+void batch_close(Batch *batch);
+
+// Loads set n into state, reusing its task table. Returns -1 on error.
+int batch_load(const Batch *batch, uint32_t n, ParserState *state);
+
+// Appends sets to a new batch file; the header and index are written by
+// batch_writer_close
+typedef struct {
+    FILE *file;
+    uint64_t *offsets;
+    uint32_t count;
+    uint32_t capacity;
+    uint64_t position;
+} BatchWriter;
+
+int batch_writer_open(BatchWriter *writer, const char *filename);
+int batch_write_set(BatchWriter *writer, const ParserState *state);
+int batch_writer_close(BatchWriter *writer);
+
+// Delivers sets [first, first + count) of a task file to `callback`,
+// whichever form it is in (count < 0: all sets from `first` on). A batch file
+// jumps straight to set `first`; a text file is scanned up to it.
+// Returns the number of sets delivered, or -1 on error.
+int load_sets(const char *filename, int first, int count, ParseSetCallback callback, void *user);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTS_BATCH_H
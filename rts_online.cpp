@@ -0,0 +1,279 @@
+#include "setup_ali.cpp"
+#include "analysis_ali.cpp"
+#include "spscqueue_ali.cpp"
+#include <queue>
+#include <tuple>
+#include <string>
+
+#include "rts_online.h"
+
+// librts: the online engine behind rts_online.h. It drives the same
+// Scheduler classes as the simulator, with the same step order at every
+// event (release, deadline misses, select, execute), but takes its tasks
+// from rts_admit() and its releases from the producer's queue. Nothing is
+// logged, so it runs for as long as the caller's system does.
+
+static_assert(RTS_NEVER == NEVER, "RTS_NEVER is the engine's NEVER");
+
+// A release on its way from the producer thread
+struct ReleaseRequest {
+    int task;
+    Tick at;
+};
+
+// A release waiting for its time: earliest first, at equal times in task
+// order as the simulator releases them, then in arrival order
+struct PendingRelease {
+    Tick at;
+    int task;
+    long long order;
+
+    bool operator>(const PendingRelease& other) const {
+        return std::tie(at, task, order) > std::tie(other.at, other.task, other.order);
+    }
+};
+
+struct RtsScheduler {
+    string policy;
+    Scheduler* sch;
+    size_t max_tasks;
+    vector<Task> tasks; // reserved up front: jobs point into it
+
+    // Admission state
+    vector<AnalysedTask> analysed;
+    vector<long long> response; // RM, DM: last response time found, 0 if none yet
+    double density = 0;         // EDF: sum of C / min(D, P)
+    double hyperbolic = 1;      // RM, DM: product of (C / P + 1)
+    bool implicit = true;       // every D = P
+
+    SpscQueue<ReleaseRequest> queue;
+    priority_queue<PendingRelease, vector<PendingRelease>, greater<PendingRelease>> pending;
+    vector<Tick> next_allowed; // per task, earliest release of its next job
+    long long arrivals = 0;
+
+    JobPool pool;
+    LiveJobs live{pool};
+    TimerWheel deadlines;
+    DueTimers due;
+    RtsCounters counters{};
+
+    RtsScheduler(const string& name, Scheduler* s, size_t n, size_t capacity)
+        : policy(name), sch(s), max_tasks(n), queue(capacity) {
+        tasks.reserve(n);
+    }
+    ~RtsScheduler() { delete sch; }
+};
+
+// Least fixed point of R = C + sum over `interference` of ceil(R / P) * C,
+// iterated up from `start` (no higher than it), or -1 once it passes D
+static long long responseFrom(const AnalysedTask& task, const vector<const AnalysedTask*>& interference,
+                              long long start) {
+    long long r = task.C;
+    for (const auto* t : interference) r += t->C;
+    r = max(r, start);
+    while (r <= task.D) {
+        long long next = task.C;
+        for (const auto* t : interference) next += (r + t->P - 1) / t->P * t->C;
+        if (next == r) return r;
+        r = next;
+    }
+    return -1;
+}
+
+// RM, DM: the new task `task` passes if it and every task it can delay
+// (priority key at least its own; ties count as interference both ways)
+// keep their deadlines. Those tasks' response times only grow, so each
+// iteration resumes from the last one found. Fills `found` on success.
+static bool fixedPriorityAdmits(const RtsScheduler* s, const AnalysedTask& task, long long AnalysedTask::*key,
+                                vector<long long>& found) {
+    vector<AnalysedTask> all = s->analysed;
+    all.push_back(task);
+    found = s->response;
+    found.push_back(0);
+    for (size_t i = 0; i < all.size(); i++) {
+        if (i + 1 < all.size() && all[i].*key < task.*key) continue;
+        vector<const AnalysedTask*> interference;
+        for (size_t j = 0; j < all.size(); j++) {
+            if (j != i && all[j].*key <= all[i].*key) interference.push_back(&all[j]);
+        }
+        found[i] = responseFrom(all[i], interference, found[i]);
+        if (found[i] < 0) return false;
+    }
+    return true;
+}
+
+// Hands the ready jobs back to the scheduler once it knows the new task set
+static void reprepare(RtsScheduler* s) {
+    vector<Job*> ready;
+    for (Job* job : s->live.all()) {
+        if (!job->isRetired()) ready.push_back(job);
+    }
+    for (Job* job : ready) s->sch->removeReady(job);
+    s->sch->prepare(s->tasks);
+    for (Job* job : ready) s->sch->addReady(job);
+}
+
+// Moves the producer's releases into the pending heap, holding back those
+// that come sooner than one period after the task's previous one
+static void drain(RtsScheduler* s) {
+    ReleaseRequest request;
+    Tick now = s->sch->getCurrentTime();
+    while (s->queue.pop(request)) {
+        if (request.task < 0 || request.task >= (int)s->tasks.size()) {
+            s->counters.ignored++;
+            continue;
+        }
+        Tick at = max(request.at, now);
+        Tick& allowed = s->next_allowed[request.task];
+        if (at < allowed) {
+            at = allowed;
+            s->counters.held_back++;
+        }
+        allowed = at + s->tasks[request.task].getP();
+        s->pending.push({at, request.task, s->arrivals++});
+    }
+}
+
+// Releases and deadline misses due at the current time
+static void settle(RtsScheduler* s) {
+    drain(s);
+    Tick now = s->sch->getCurrentTime();
+    while (!s->pending.empty() && s->pending.top().at <= now) {
+        const Task& task = s->tasks[s->pending.top().task];
+        s->pending.pop();
+        Job* job = s->pool.create(&task, now, s->counters.released++);
+        s->live.push(job);
+        s->sch->addReady(job);
+        armDeadline(s->deadlines, job);
+    }
+    s->due.collect(s->deadlines, now);
+    for (TimerNode* timer : s->due.deadlines) {
+        s->sch->removeReady(timer->job);
+        s->live.retire(timer->job);
+        s->counters.missed++;
+    }
+}
+
+// Next instant at which the decision for `job` (NULL: idle) may change
+static Tick nextEvent(RtsScheduler* s, Job* job) {
+    Tick next = s->deadlines.nextExpiry();
+    if (!s->pending.empty()) next = min(next, s->pending.top().at);
+    if (job) {
+        next = min(next, s->sch->getCurrentTime() + max<Tick>(1, job->getRem()));
+        next = min(next, s->sch->decisionHorizon(job));
+    }
+    return next;
+}
+
+extern "C" {
+
+RtsScheduler* rts_create(const char* policy, int max_tasks, size_t queue_capacity) {
+    string name = policy ? policy : "";
+    // Only the policies the admission tests can prove
+    if (name != "RM" && name != "DM" && name != "EDF") return NULL;
+    return new RtsScheduler(name, makePeriodicScheduler(name), max(max_tasks, 0), max<size_t>(queue_capacity, 1));
+}
+
+void rts_destroy(RtsScheduler* s) {
+    delete s;
+}
+
+RtsAdmission rts_admit(RtsScheduler* s, const RtsTaskParams* params) {
+    RtsAdmission result = {RTS_REJECTED, -1, ""};
+    if (!params || params->wcet < 0 || params->period <= 0 || params->deadline < 0) {
+        result.status = RTS_INVALID;
+        return result;
+    }
+    if (s->tasks.size() >= s->max_tasks) {
+        result.status = RTS_FULL;
+        return result;
+    }
+    Tick d = params->deadline > 0 ? params->deadline : params->period;
+    // A job with zero execution time still occupies one tick
+    AnalysedTask task = {max<long long>(params->wcet, 1), params->period, d, (int)s->tasks.size()};
+
+    vector<long long> found;
+    double density = (double)task.C / min(task.D, task.P);
+    double hyperbolic = s->hyperbolic * ((double)task.C / task.P + 1);
+    bool implicit = s->implicit && task.D == task.P;
+    if (s->policy == "EDF") {
+        if (s->density + density <= 1) {
+            result.test = "density bound";
+        } else if (d <= params->period) {
+            vector<AnalysedTask> all = s->analysed;
+            all.push_back(task);
+            bool constrained = true;
+            for (const auto& t : all) constrained = constrained && t.D <= t.P;
+            if (constrained && processorDemand(all).verdict == SCHEDULABLE) result.test = "processor demand analysis";
+        }
+    } else if (d <= params->period) {
+        // As in analyzeTasks: with D > P a job can still run when the next
+        // one is released, which a first-job response time does not cover
+        if (implicit && hyperbolic <= 2.0) result.test = "hyperbolic bound";
+        else if (fixedPriorityAdmits(s, task, s->policy == "RM" ? &AnalysedTask::P : &AnalysedTask::D, found)) {
+            result.test = "response-time analysis";
+        }
+    }
+    if (*result.test == '\0') return result;
+
+    s->density += density;
+    s->hyperbolic = hyperbolic;
+    s->implicit = implicit;
+    s->analysed.push_back(task);
+    if (found.empty()) s->response.push_back(0);
+    else s->response.swap(found);
+    s->tasks.emplace_back(Periodic, params->wcet, params->period, 0, d);
+    s->next_allowed.push_back(s->sch->getCurrentTime());
+    reprepare(s);
+    result.status = RTS_ADMITTED;
+    result.task = task.index;
+    return result;
+}
+
+int rts_release(RtsScheduler* s, int task, RtsTick at) {
+    return s->queue.push({task, at}) ? 0 : -1;
+}
+
+void rts_tick_until(RtsScheduler* s, RtsTick t) {
+    Scheduler* sch = s->sch;
+    while (true) {
+        settle(s);
+        Tick now = sch->getCurrentTime();
+        if (now >= t) break;
+        Job* job = sch->selectTask();
+        Tick dt = min<Tick>(t, nextEvent(s, job)) - now;
+        if (job) sch->execute_server_version(job, dt);
+        sch->clockTick(dt);
+        if (job && job->isComplete()) {
+            sch->removeReady(job);
+            sch->addFinishedJob(job);
+            s->deadlines.remove(&job->deadline_timer);
+            s->live.retire(job);
+        }
+    }
+}
+
+RtsDecision rts_next_decision(RtsScheduler* s) {
+    settle(s);
+    Job* job = s->sch->selectTask();
+    RtsDecision decision = {-1, -1, 0, RTS_NEVER, nextEvent(s, job)};
+    if (job) {
+        decision.task = job->getTask() - s->tasks.data();
+        decision.job = job->hook.seq;
+        decision.remaining = max<Tick>(job->getRem(), 1);
+        decision.deadline = job->getAbsDeadline();
+    }
+    return decision;
+}
+
+RtsTick rts_now(const RtsScheduler* s) {
+    return s->sch->getCurrentTime();
+}
+
+RtsCounters rts_counters(const RtsScheduler* s) {
+    RtsCounters counters = s->counters;
+    counters.completed = s->sch->getFinishedCount();
+    return counters;
+}
+
+}
@@ -0,0 +1,101 @@
+#ifndef RTS_ONLINE_H
+#define RTS_ONLINE_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Online scheduling engine (librts): the simulator's RM, DM and EDF policies
+// for a runtime dispatcher, fed task by task and job by job instead of from
+// a task file. Build with `make librts` and link librts.a with a C++ linker
+// (or -lstdc++ -pthread).
+//
+// Times are integer ticks of the caller's clock. Tasks are sporadic: a task
+// releases a job whenever the caller says so, but never sooner than one
+// period after its previous job; a release that comes too early is held
+// back until then, so the admission tests keep holding. Each job runs for
+// its task's WCET (at least one tick), fully preemptively; a job still
+// unfinished at its deadline is dropped, as in the simulator.
+//
+// Threads: rts_release() may be called from one producer thread while one
+// scheduler thread makes every other call. Releases travel through a
+// bounded lock-free single-producer/single-consumer queue and take effect
+// at the scheduler thread's next rts_tick_until() or rts_next_decision().
+
+typedef long long RtsTick;
+
+typedef struct RtsScheduler RtsScheduler;
+
+typedef struct {
+    RtsTick wcet;
+    RtsTick period;   // minimum time between releases
+    RtsTick deadline; // relative; 0 = period
+} RtsTaskParams;
+
+typedef enum {
+    RTS_ADMITTED,
+    RTS_REJECTED, // the policy's tests cannot guarantee the deadlines with the task
+    RTS_FULL,     // max_tasks tasks admitted already
+    RTS_INVALID   // wcet < 0, period <= 0 or deadline < 0
+} RtsAdmitStatus;
+
+typedef struct {
+    RtsAdmitStatus status;
+    int task;         // handle for rts_release(), -1 unless admitted
+    const char *test; // the test that decided, "" if none did
+} RtsAdmission;
+
+// What runs from the current time on, and until when that holds unless a
+// release comes in
+typedef struct {
+    int task;         // -1: the processor idles
+    long long job;    // release sequence number of the job
+    RtsTick remaining;
+    RtsTick deadline; // absolute
+    RtsTick until;    // next instant the choice may change; RTS_NEVER if none
+} RtsDecision;
+
+typedef struct {
+    long long released;
+    long long completed;
+    long long missed;    // dropped at their deadline
+    long long held_back; // releases delayed to one period after the previous one
+    long long ignored;   // releases for a task handle never admitted
+} RtsCounters;
+
+#define RTS_NEVER 0x7fffffffffffffffLL
+
+// `policy`: "RM", "DM" or "EDF". Room for `max_tasks` tasks and for
+// `queue_capacity` releases in flight (rounded up to a power of two).
+// Returns NULL for an unknown policy.
+RtsScheduler *rts_create(const char *policy, int max_tasks, size_t queue_capacity);
+void rts_destroy(RtsScheduler *s);
+
+// Admission control, O(1) while the utilization bounds decide (density for
+// EDF, hyperbolic bound for RM and DM with implicit deadlines); otherwise
+// EDF falls back to processor demand analysis, and RM and DM to
+// response-time analysis of the new task and of those it can delay,
+// resumed from their last response times. RM and DM reject a task whose
+// deadline is beyond its period. Scheduler thread.
+RtsAdmission rts_admit(RtsScheduler *s, const RtsTaskParams *params);
+
+// Releases a job of `task` at time `at` (the current time if earlier).
+// Producer thread. Returns 0, or -1 if the queue is full.
+int rts_release(RtsScheduler *s, int task, RtsTick at);
+
+// Runs the schedule up to time `t`. Scheduler thread.
+void rts_tick_until(RtsScheduler *s, RtsTick t);
+
+// The dispatch decision at the current time. Scheduler thread.
+RtsDecision rts_next_decision(RtsScheduler *s);
+
+RtsTick rts_now(const RtsScheduler *s);
+RtsCounters rts_counters(const RtsScheduler *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTS_ONLINE_H
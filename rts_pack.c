@@ -0,0 +1,84 @@
+#include "rts_batch.h"
+#include <stdio.h>
+#include <string.h>
+
+// Converts task files into a binary batch (rts_batch.h) so repeated runs
+// skip text parsing, and prints a batch back as a multi-set text file.
+
+typedef struct {
+    BatchWriter writer;
+    int failed;
+} Pack;
+
+static int pack_set(ParserState *state, int set_index, void *user) {
+    (void)set_index;
+    Pack *pack = (Pack *)user;
+    if (batch_write_set(&pack->writer, state) < 0) pack->failed = 1;
+    return pack->failed;
+}
+
+static const char *server_name(ParsedServerType type) {
+    switch (type) {
+        case SERVER_POLLER: return "POLLER";
+        case SERVER_DEFERRABLE: return "DEFERABLE";
+        case SERVER_BACKGROUND: return "BACKGROUND";
+        case SERVER_SPORADIC: return "SPORADIC";
+        case SERVER_TBS: return "TBS";
+        case SERVER_CBS: return "CBS";
+        default: return "NONE";
+    }
+}
+
+static int print_set(ParserState *state, int set_index, void *user) {
+    (void)user;
+    if (set_index > 0) printf("%s set %d\n", SET_DELIMITER, set_index + 1);
+    for (int i = 0; i < state->task_count; i++) {
+        ParsedTask *t = &state->tasks[i];
+        switch (t->type) {
+            case PARSED_TASK_PERIODIC:
+                printf("P %d %d %d %d", t->release_time, t->execution_time, t->period, t->deadline);
+                if (t->criticality == CRITICALITY_HI) printf(" HI %d", t->execution_time_hi);
+                printf("\n");
+                break;
+            case PARSED_TASK_DYNAMIC:
+                printf("D %d %d %d\n", t->execution_time, t->period, t->deadline);
+                break;
+            case PARSED_TASK_APERIODIC:
+                printf("A %d %d\n", t->release_time, t->execution_time);
+                break;
+        }
+    }
+    if (state->server.type != SERVER_NONE) {
+        printf("S %d %d %s %s\n", state->server.budget, state->server.period, server_name(state->server.type),
+               state->server.scheduling == SCHED_EDF ? "EDF" : "RM");
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc == 3 && strcmp(argv[1], "--unpack") == 0) {
+        return load_sets(argv[2], 0, -1, print_set, NULL) < 0 ? 1 : 0;
+    }
+    if (argc < 4 || strcmp(argv[1], "-o") != 0) {
+        printf("Usage: %s -o <batch_file> <task_file_1> [task_file_2] ...\n", argv[0]);
+        printf("       %s --unpack <batch_file>\n", argv[0]);
+        printf("\nEvery task set of the inputs (text or batch files) is packed in order.\n");
+        return 1;
+    }
+
+    Pack pack;
+    pack.failed = 0;
+    if (batch_writer_open(&pack.writer, argv[2]) < 0) return 1;
+    for (int i = 3; i < argc && !pack.failed; i++) {
+        if (load_sets(argv[i], 0, -1, pack_set, &pack) < 0 || pack.failed) {
+            fprintf(stderr, "Error: Failed to pack '%s'\n", argv[i]);
+            pack.failed = 1;
+        }
+    }
+    if (batch_writer_close(&pack.writer) < 0) {
+        fprintf(stderr, "Error: Failed to write '%s'\n", argv[2]);
+        pack.failed = 1;
+    }
+    if (!pack.failed) printf("Packed %u task sets into %s\n", pack.writer.count, argv[2]);
+    return pack.failed;
+}
@@ -1,64 +1,151 @@
+#define _DEFAULT_SOURCE // madvise
 #include "rts_parser.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <math.h>
+#include <limits.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// The parser works on [start, end) slices of the input, which is mapped
+// straight from the file: lines are never copied or NUL-terminated.
 
 // Internal function prototypes
-static int parse_line(char *line, ParserState *state);
-static int parse_periodic_task(char *line, ParserState *state);
-static int parse_dynamic_task(char *line, ParserState *state);
-static int parse_aperiodic_task(char *line, ParserState *state);
-static int parse_server_config(char *line, ParserState *state);
-static void trim_whitespace(char *str);
+static int parse_line(const char *line, const char *end, ParserState *state);
+static int parse_periodic_task(const char *p, const char *end, ParserState *state);
+static int parse_dynamic_task(const char *p, const char *end, ParserState *state);
+static int parse_aperiodic_task(const char *p, const char *end, ParserState *state);
+static int parse_server_config(const char *p, const char *end, ParserState *state);
 
 // Initialize parser state
 void init_parser_state(ParserState *state) {
+    state->tasks = NULL;
     state->task_count = 0;
+    state->task_capacity = 0;
     state->server.type = SERVER_NONE;
     state->server.budget = 0;
     state->server.period = 0;
     state->server.scheduling = SCHED_NONE;
 }
 
-// Trim leading and trailing whitespace from a string
-static void trim_whitespace(char *str) {
-    if (!str) return;
-    char *start = str;
-    while (isspace((unsigned char)*start)) {
-        start++;
-    }
+void free_parser_state(ParserState *state) {
+    free(state->tasks);
+    init_parser_state(state);
+}
 
-    if (*start == 0) {
-        *str = 0;
-        return;
-    }
+void take_parser_state(ParserState *dst, ParserState *src) {
+    *dst = *src;
+    init_parser_state(src);
+}
 
-    char *end = start + strlen(start) - 1;
-    while (end > start && isspace((unsigned char)*end)) {
-        end--;
+// Empties the state for the next set but keeps the table allocated
+static void reset_parser_state(ParserState *state) {
+    ParsedTask *tasks = state->tasks;
+    int capacity = state->task_capacity;
+    init_parser_state(state);
+    state->tasks = tasks;
+    state->task_capacity = capacity;
+}
+
+static int add_task(ParserState *state, const ParsedTask *task) {
+    if (state->task_count == state->task_capacity) {
+        int capacity = state->task_capacity ? 2 * state->task_capacity : 16;
+        ParsedTask *tasks = realloc(state->tasks, (size_t)capacity * sizeof(ParsedTask));
+        if (tasks == NULL) {
+            fprintf(stderr, "Error: Out of memory for %d tasks.\n", capacity);
+            return -1;
+        }
+        state->tasks = tasks;
+        state->task_capacity = capacity;
     }
-    *(end + 1) = 0;
+    state->tasks[state->task_count++] = *task;
+    return 0;
+}
 
-    if (str != start) {
-        memmove(str, start, strlen(start) + 1);
+static int is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static const char *skip_blanks(const char *p, const char *end) {
+    while (p < end && is_blank(*p)) p++;
+    return p;
+}
+
+static const char *skip_token(const char *p, const char *end) {
+    while (p < end && !is_blank(*p)) p++;
+    return p;
+}
+
+// Leading [+-]digits of p, saturating at the int range; returns the first
+// character after the digits, or NULL if there are none
+static const char *scan_digits(const char *p, const char *end, int *value) {
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+    if (p == end || !isdigit((unsigned char)*p)) return NULL;
+    long long v = 0;
+    while (p < end && isdigit((unsigned char)*p)) {
+        if (v <= INT_MAX) v = v * 10 + (*p - '0');
+        p++;
     }
+    if (v > INT_MAX) v = negative ? -(long long)INT_MIN : INT_MAX;
+    *value = (int)(negative ? -v : v);
+    return p;
 }
 
-// Parse periodic task: P [ri] ei pi [di]
-static int parse_periodic_task(char *line, ParserState *state) {
+// Integer after optional blanks, like sscanf's %d; returns 0 if there is none
+static int scan_int(const char **p, const char *end, int *value) {
+    const char *next = scan_digits(skip_blanks(*p, end), end, value);
+    if (next == NULL) return 0;
+    *p = next;
+    return 1;
+}
+
+// Next blank-separated word; returns its length, 0 at the end of the line
+static size_t scan_word(const char **p, const char *end, const char **word) {
+    *word = skip_blanks(*p, end);
+    *p = skip_token(*word, end);
+    return *p - *word;
+}
+
+static int word_is(const char *word, size_t length, const char *keyword) {
+    return strlen(keyword) == length && memcmp(word, keyword, length) == 0;
+}
+
+// Parse periodic task: P [ri] ei pi [di] [HI ei_hi | LO]
+static int parse_periodic_task(const char *p, const char *end, ParserState *state) {
     ParsedTask task;
     task.type = PARSED_TASK_PERIODIC;
 
     int values[4];
     int count = 0;
-    char *token = strtok(line, " 	"); // Skip 'P'
-    token = strtok(NULL, " 	");
-
-    while (token != NULL && count < 4) {
-        values[count++] = atoi(token);
-        token = strtok(NULL, " 	");
+    const char *token;
+    size_t length;
+    scan_word(&p, end, &token); // Skip 'P'
+
+    // Each token counts, like atoi: a non-numeric one reads as 0. A
+    // criticality keyword ends the numbers.
+    task.criticality = CRITICALITY_LO;
+    while ((length = scan_word(&p, end, &token)) > 0) {
+        if (word_is(token, length, "HI") || word_is(token, length, "LO")) {
+            if (token[0] == 'H') task.criticality = CRITICALITY_HI;
+            break;
+        }
+        if (count == 4) break;
+        if (scan_digits(token, p, &values[count]) == NULL) values[count] = 0;
+        count++;
+    }
+    if (task.criticality == CRITICALITY_HI && !scan_int(&p, end, &task.execution_time_hi)) {
+        fprintf(stderr, "Error: Invalid criticality. Expected 'HI ei_hi' after the periodic task.\n");
+        return -1;
     }
 
     if (count == 2) { // P ei pi
@@ -80,61 +167,62 @@ static int parse_periodic_task(char *line, ParserState *state) {
         fprintf(stderr, "Error: Invalid periodic task format. Expected 'P [ri] ei pi [di]'.\n");
         return -1;
     }
-
-    if (state->task_count >= MAX_TASKS) {
-        fprintf(stderr, "Error: Maximum number of tasks exceeded.\n");
+    if (task.criticality == CRITICALITY_LO) {
+        task.execution_time_hi = task.execution_time;
+    } else if (task.execution_time_hi < task.execution_time) {
+        fprintf(stderr, "Error: The HI-criticality execution time must be at least the LO one.\n");
         return -1;
     }
-    state->tasks[state->task_count++] = task;
-    return 0;
+
+    return add_task(state, &task);
 }
 
 // Parse dynamic task: D ei pi di
-static int parse_dynamic_task(char *line, ParserState *state) {
+static int parse_dynamic_task(const char *p, const char *end, ParserState *state) {
     ParsedTask task;
     task.type = PARSED_TASK_DYNAMIC;
 
-    if (sscanf(line, "D %d %d %d", &task.execution_time, &task.period, &task.deadline) != 3) {
+    p++; // 'D'
+    if (!scan_int(&p, end, &task.execution_time) || !scan_int(&p, end, &task.period) ||
+        !scan_int(&p, end, &task.deadline)) {
         fprintf(stderr, "Error: Invalid dynamic task format. Expected 'D ei pi di'.\n");
         return -1;
     }
     task.release_time = 0; // Dynamic tasks start at time 0
+    task.criticality = CRITICALITY_LO;
+    task.execution_time_hi = task.execution_time;
 
-    if (state->task_count >= MAX_TASKS) {
-        fprintf(stderr, "Error: Maximum number of tasks exceeded.\n");
-        return -1;
-    }
-    state->tasks[state->task_count++] = task;
-    return 0;
+    return add_task(state, &task);
 }
 
 // Parse aperiodic task: A ri ei
-static int parse_aperiodic_task(char *line, ParserState *state) {
+static int parse_aperiodic_task(const char *p, const char *end, ParserState *state) {
     ParsedTask task;
     task.type = PARSED_TASK_APERIODIC;
-    
-    if (sscanf(line, "A %d %d", &task.release_time, &task.execution_time) != 2) {
+
+    p++; // 'A'
+    if (!scan_int(&p, end, &task.release_time) || !scan_int(&p, end, &task.execution_time)) {
         fprintf(stderr, "Error: Invalid aperiodic task format. Expected 'A ri ei'.\n");
         return -1;
     }
     task.period = -1;
     task.deadline = 0;
+    task.criticality = CRITICALITY_LO;
+    task.execution_time_hi = task.execution_time;
 
-    if (state->task_count >= MAX_TASKS) {
-        fprintf(stderr, "Error: Maximum number of tasks exceeded.\n");
-        return -1;
-    }
-    state->tasks[state->task_count++] = task;
-    return 0;
+    return add_task(state, &task);
 }
 
 // Parse server config: S es ps TYPE SCHEDULING
-static int parse_server_config(char *line, ParserState *state) {
-    char server_type_str[50];
-    char scheduling_type_str[50];
+static int parse_server_config(const char *p, const char *end, ParserState *state) {
+    const char *server_type_str, *scheduling_type_str;
+    size_t server_type_len, scheduling_type_len;
     int budget, period;
 
-    if (sscanf(line, "S %d %d %49s %49s", &budget, &period, server_type_str, scheduling_type_str) != 4) {
+    p++; // 'S'
+    if (!scan_int(&p, end, &budget) || !scan_int(&p, end, &period) ||
+        (server_type_len = scan_word(&p, end, &server_type_str)) == 0 ||
+        (scheduling_type_len = scan_word(&p, end, &scheduling_type_str)) == 0) {
         fprintf(stderr, "Error: Invalid server format. Expected 'S es ps TYPE SCHEDULING'.\n");
         return -1;
     }
@@ -142,72 +230,253 @@ static int parse_server_config(char *line, ParserState *state) {
     state->server.budget = budget;
     state->server.period = period;
 
-    if (strcmp(server_type_str, "DEFERABLE") == 0) {
+    if (word_is(server_type_str, server_type_len, "DEFERABLE")) {
         state->server.type = SERVER_DEFERRABLE;
-    } else if (strcmp(server_type_str, "POLLER") == 0) {
+    } else if (word_is(server_type_str, server_type_len, "POLLER")) {
         state->server.type = SERVER_POLLER;
-    } else if (strcmp(server_type_str, "BACKGROUND") == 0) {
+    } else if (word_is(server_type_str, server_type_len, "BACKGROUND")) {
         state->server.type = SERVER_BACKGROUND;
+    } else if (word_is(server_type_str, server_type_len, "SPORADIC")) {
+        state->server.type = SERVER_SPORADIC;
+    } else if (word_is(server_type_str, server_type_len, "TBS")) {
+        state->server.type = SERVER_TBS;
+    } else if (word_is(server_type_str, server_type_len, "CBS")) {
+        state->server.type = SERVER_CBS;
     } else {
-        fprintf(stderr, "Error: Unknown server type '%s'. Use 'POLLER' or 'DEFERABLE' or 'BACKGROUND'.\n", server_type_str);
+        fprintf(stderr, "Error: Unknown server type '%.*s'. Use 'POLLER', 'DEFERABLE', 'BACKGROUND', "
+                "'SPORADIC', 'TBS' or 'CBS'.\n", (int)server_type_len, server_type_str);
         return -1;
     }
 
-    if (strcmp(scheduling_type_str, "RM") == 0) {
+    if (word_is(scheduling_type_str, scheduling_type_len, "RM")) {
         state->server.scheduling = SCHED_RM;
-    } else if (strcmp(scheduling_type_str, "EDF") == 0) {
+    } else if (word_is(scheduling_type_str, scheduling_type_len, "EDF")) {
         state->server.scheduling = SCHED_EDF;
     } else {
-        fprintf(stderr, "Error: Unknown scheduling type '%s'. Use 'RM' or 'EDF'.\n", scheduling_type_str);
+        fprintf(stderr, "Error: Unknown scheduling type '%.*s'. Use 'RM' or 'EDF'.\n",
+                (int)scheduling_type_len, scheduling_type_str);
         return -1;
     }
+
+    // The bandwidth servers are defined by their utilization es / ps and run under EDF
+    if (state->server.type == SERVER_TBS || state->server.type == SERVER_CBS) {
+        if (state->server.scheduling != SCHED_EDF) {
+            fprintf(stderr, "Error: TBS and CBS servers need EDF scheduling.\n");
+            return -1;
+        }
+        if (budget <= 0 || period < budget) {
+            fprintf(stderr, "Error: TBS and CBS servers need 0 < es <= ps.\n");
+            return -1;
+        }
+    }
     return 0;
 }
 
 
 // Main line parsing function
-static int parse_line(char *line, ParserState *state) {
-    trim_whitespace(line);
-    if (strlen(line) == 0 || line[0] == '#') {
+static int parse_line(const char *line, const char *end, ParserState *state) {
+    line = skip_blanks(line, end);
+    while (end > line && is_blank(end[-1])) end--;
+    if (line == end || line[0] == '#') {
         return 0; // Skip empty lines and comments
     }
 
     switch (line[0]) {
-        case 'P': return parse_periodic_task(line, state);
-        case 'D': return parse_dynamic_task(line, state);
-        case 'A': return parse_aperiodic_task(line, state);
-        case 'S': return parse_server_config(line, state);
+        case 'P': return parse_periodic_task(line, end, state);
+        case 'D': return parse_dynamic_task(line, end, state);
+        case 'A': return parse_aperiodic_task(line, end, state);
+        case 'S': return parse_server_config(line, end, state);
         default:
-            fprintf(stderr, "Warning: Unknown line format, ignoring: %s\n", line);
+            fprintf(stderr, "Warning: Unknown line format, ignoring: %.*s\n", (int)(end - line), line);
             return 0;
     }
 }
 
-// Parse file
-int parse_file(const char *filename, ParserState *state) {
-    FILE *file = fopen(filename, "r");
-    if (file == NULL) {
-        fprintf(stderr, "Error: Cannot open file '%s'\n", filename);
-        return -1;
-    }
+static int is_delimiter(const char *line, const char *end) {
+    size_t n = strlen(SET_DELIMITER);
+    line = skip_blanks(line, end);
+    return (size_t)(end - line) >= n && memcmp(line, SET_DELIMITER, n) == 0;
+}
 
-    char line[MAX_LINE_LENGTH];
+// Bytes of an mmapped input the parser moves past before handing the pages
+// back to the kernel
+#define RELEASE_CHUNK (64u << 20)
+
+// Parses [data, data + length) set by set. With `mapped` set the data is a
+// file mapping whose pages are released once the parser is past them.
+static int parse_sets(const char *data, size_t length, const char *name, int mapped,
+                      ParseSetCallback callback, void *user) {
+    ParserState state;
+    init_parser_state(&state);
+    const char *p = data, *end = data + length;
+    const char *released = data;
     int line_number = 0;
-    init_parser_state(state); // Ensure state is clean before parsing
+    int sets = 0;
+    int stopped = 0;
 
-    while (fgets(line, sizeof(line), file)) {
+    while (p < end && !stopped) {
+        const char *eol = memchr(p, '\n', end - p);
+        if (eol == NULL) eol = end;
         line_number++;
-        if (parse_line(line, state) < 0) {
-            fprintf(stderr, "Error parsing file '%s' at line %d.\n", filename, line_number);
-            fclose(file);
+        if (is_delimiter(p, eol)) {
+            stopped = callback(&state, sets++, user);
+            reset_parser_state(&state);
+        } else if (parse_line(p, eol, &state) < 0) {
+            fprintf(stderr, "Error parsing file '%s' at line %d.\n", name, line_number);
+            free_parser_state(&state);
             return -1;
         }
+        p = eol + 1;
+#ifndef _WIN32
+        if (mapped && (size_t)(p - released) >= RELEASE_CHUNK) {
+            size_t page = (size_t)sysconf(_SC_PAGESIZE);
+            size_t done = (size_t)(p - data) / page * page;
+            madvise((void *)released, data + done - released, MADV_DONTNEED);
+            released = data + done;
+        }
+#endif
+    }
+    // Trailing set; a delimiter at the very end does not open an empty one
+    if (!stopped && (sets == 0 || state.task_count > 0 || state.server.type != SERVER_NONE)) {
+        callback(&state, sets++, user);
     }
+    (void)mapped;
+    (void)released;
+    free_parser_state(&state);
+    return sets;
+}
 
-    fclose(file);
+int parse_buffer(const char *data, size_t length, const char *name, ParseSetCallback callback, void *user) {
+    return parse_sets(data, length, name, 0, callback, user);
+}
+
+// Fallback for inputs that cannot be mapped (pipes, special files)
+static int read_whole(FILE *stream, const char *filename, MappedFile *file) {
+    size_t length = 0, capacity = 1 << 16;
+    char *data = malloc(capacity);
+    size_t n;
+    while (data && (n = fread(data + length, 1, capacity - length, stream)) > 0) {
+        length += n;
+        if (length == capacity) {
+            char *grown = realloc(data, capacity *= 2);
+            if (grown == NULL) free(data);
+            data = grown;
+        }
+    }
+    if (data == NULL) {
+        fprintf(stderr, "Error: Out of memory reading '%s'\n", filename);
+        return -1;
+    }
+    file->data = data;
+    file->length = length;
+    file->mapped = 0;
     return 0;
 }
 
+int map_file(const char *filename, MappedFile *file) {
+    file->data = "";
+    file->length = 0;
+    file->mapped = 0;
+    file->handle = NULL;
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "Error: Cannot open file '%s'\n", filename);
+        return -1;
+    }
+    LARGE_INTEGER size;
+    size.QuadPart = -1;
+    GetFileSizeEx(handle, &size);
+    if (size.QuadPart == 0) {
+        CloseHandle(handle);
+        return 0;
+    }
+    HANDLE mapping = size.QuadPart > 0 ? CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    CloseHandle(handle);
+    const char *data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (data) {
+        file->data = data;
+        file->length = (size_t)size.QuadPart;
+        file->mapped = 1;
+        file->handle = mapping;
+        return 0;
+    }
+    if (mapping) CloseHandle(mapping);
+    FILE *stream = fopen(filename, "rb");
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Cannot open file '%s'\n", filename);
+        return -1;
+    }
+    struct stat info;
+    int regular = fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+    if (regular && info.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    void *data = regular ? mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    if (data != MAP_FAILED) {
+        close(fd);
+        madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+        file->data = data;
+        file->length = (size_t)info.st_size;
+        file->mapped = 1;
+        return 0;
+    }
+    FILE *stream = fdopen(fd, "rb");
+    if (stream == NULL) close(fd);
+#endif
+    if (stream == NULL) {
+        fprintf(stderr, "Error: Cannot open file '%s'\n", filename);
+        return -1;
+    }
+    int status = read_whole(stream, filename, file);
+    fclose(stream);
+    return status;
+}
+
+void unmap_file(MappedFile *file) {
+    if (file->mapped) {
+#ifdef _WIN32
+        UnmapViewOfFile(file->data);
+        CloseHandle(file->handle);
+#else
+        munmap((void *)file->data, file->length);
+#endif
+    } else if (file->length > 0) {
+        free((void *)file->data);
+    }
+    file->data = "";
+    file->length = 0;
+    file->mapped = 0;
+}
+
+int parse_mapped(const MappedFile *file, const char *name, ParseSetCallback callback, void *user) {
+    return parse_sets(file->data, file->length, name, file->mapped, callback, user);
+}
+
+int parse_stream(const char *filename, ParseSetCallback callback, void *user) {
+    MappedFile file;
+    if (map_file(filename, &file) < 0) return -1;
+    int sets = parse_mapped(&file, filename, callback, user);
+    unmap_file(&file);
+    return sets;
+}
+
+static int keep_first_set(ParserState *state, int set_index, void *user) {
+    (void)set_index;
+    take_parser_state((ParserState *)user, state);
+    return 1;
+}
+
+// Parse file
+int parse_file(const char *filename, ParserState *state) {
+    init_parser_state(state); // Ensure state is clean before parsing
+    return parse_stream(filename, keep_first_set, state) < 0 ? -1 : 0;
+}
+
 // --- Utility printing functions ---
 
 const char* task_type_to_string(ParsedTaskType type) {
@@ -224,6 +493,9 @@ const char* server_type_to_string(ParsedServerType type) {
         case SERVER_POLLER: return "POLLER";
         case SERVER_DEFERRABLE: return "DEFERRABLE";
         case SERVER_BACKGROUND: return "BACKGROUND";
+        case SERVER_SPORADIC: return "SPORADIC";
+        case SERVER_TBS: return "TBS";
+        case SERVER_CBS: return "CBS";
         default: return "NONE";
     }
 }
@@ -242,8 +514,10 @@ void print_tasks(ParserState *state) {
     for (int i = 0; i < state->task_count; i++) {
         ParsedTask *t = &state->tasks[i];
         printf("Task %d (%s):\n", i + 1, task_type_to_string(t->type));
-        printf("  Release: %d, Exec: %d, Period: %d, Deadline: %f\n\n",
+        printf("  Release: %d, Exec: %d, Period: %d, Deadline: %f\n",
                t->release_time, t->execution_time, (t->type == PARSED_TASK_APERIODIC) ? state->server.period :  t->period, (t->type == PARSED_TASK_APERIODIC) ? INFINITY: t->deadline);
+        if (t->criticality == CRITICALITY_HI) printf("  Criticality: HI, HI exec: %d\n", t->execution_time_hi);
+        printf("\n");
     }
 }
 
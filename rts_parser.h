@@ -6,8 +6,10 @@
 extern "C" {
 #endif
 
-#define MAX_TASKS 50
-#define MAX_LINE_LENGTH 256
+#include <stddef.h>
+
+// A line starting with this separates task sets in a multi-set file
+#define SET_DELIMITER "---"
 
 // Represents the type of a parsed task
 typedef enum {
@@ -16,13 +18,21 @@ typedef enum {
     PARSED_TASK_APERIODIC
 } ParsedTaskType;
 
+// Criticality of a task in a mixed-criticality set
+typedef enum {
+    CRITICALITY_LO,
+    CRITICALITY_HI
+} ParsedCriticality;
+
 // Represents a single task parsed from the input file
 typedef struct {
     ParsedTaskType type;
     int release_time;
-    int execution_time;
+    int execution_time;     // WCET at LO criticality, the one every policy plans with
     int period;
     int deadline;
+    ParsedCriticality criticality;
+    int execution_time_hi;  // WCET at HI criticality; execution_time for LO tasks
 } ParsedTask;
 
 // Represents the type of server parsed from the file
@@ -30,7 +40,10 @@ typedef enum {
     SERVER_NONE,
     SERVER_POLLER,
     SERVER_DEFERRABLE,
-    SERVER_BACKGROUND
+    SERVER_BACKGROUND,
+    SERVER_SPORADIC,
+    SERVER_TBS,         // total bandwidth server, EDF only
+    SERVER_CBS          // constant bandwidth server, EDF only
 } ParsedServerType;
 
 // Represents the scheduling algorithm type
@@ -48,21 +61,54 @@ typedef struct {
     ParsedSchedulingType scheduling;
 } ParsedServerConfig;
 
-// Holds the entire state of the parser after reading a file
+// Holds the entire state of the parser after reading a task set
 typedef struct {
-    ParsedTask tasks[MAX_TASKS];
+    ParsedTask *tasks;  // growable table owned by the state, see free_parser_state
     int task_count;
+    int task_capacity;
     ParsedServerConfig server;
 } ParserState;
 
+// Called once per task set, in file order. The state is reused for the next
+// set, so keep it with take_parser_state. A non-zero return stops parsing.
+typedef int (*ParseSetCallback)(ParserState *state, int set_index, void *user);
+
 // --- Function Prototypes ---
 
-// Initializes a ParserState struct to default values
+// Initializes a ParserState struct to default values (an empty table)
 void init_parser_state(ParserState *state);
 
-// Parses a task file and populates the ParserState struct
+// Releases the task table and leaves the state empty
+void free_parser_state(ParserState *state);
+
+// Moves src's contents into dst (which must not own a table); src is left empty
+void take_parser_state(ParserState *dst, ParserState *src);
+
+// Parses the first task set of a file into the ParserState struct
 int parse_file(const char *filename, ParserState *state);
 
+// Streams every task set of a file to `callback`. The file is memory-mapped
+// and parsed in place, so only the set being parsed has to be resident.
+// Returns the number of sets delivered, or -1 on error.
+int parse_stream(const char *filename, ParseSetCallback callback, void *user);
+
+// Same as parse_stream over an in-memory text; `name` is used in messages
+int parse_buffer(const char *data, size_t length, const char *name, ParseSetCallback callback, void *user);
+
+// A whole input file, memory-mapped when possible, read into memory otherwise
+typedef struct {
+    const char *data;
+    size_t length;
+    int mapped;    // 1 if data is a read-only file mapping
+    void *handle;  // platform mapping handle, if any
+} MappedFile;
+
+int map_file(const char *filename, MappedFile *file);
+void unmap_file(MappedFile *file);
+
+// parse_stream over a file mapped by map_file
+int parse_mapped(const MappedFile *file, const char *name, ParseSetCallback callback, void *user);
+
 // Utility functions to print the parsed data
 void print_tasks(ParserState *state);
 void print_server_config(ParserState *state);
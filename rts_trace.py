@@ -0,0 +1,171 @@
+"""
+Reader for the binary traces run_ali writes with --trace-out PREFIX.
+
+The file is mapped with numpy.memmap, so nothing is parsed: every column of
+a row group is a view straight into the file. The layout is documented in
+traceout_ali.cpp:
+
+    128-byte header, then row groups of rows_per_group rows (the last one
+    with the rows that are left), each holding the columns start, end,
+    seq, deadline (int64), task, core (int32), kind, type (uint8) one
+    after the other
+"""
+
+import sys
+from dataclasses import dataclass
+from typing import Dict, List, Tuple
+
+import numpy as np
+
+TRACE_MAGIC = b"RTSTRACE"
+TRACE_VERSION = 1
+
+# Row kinds
+TRACE_SLICE = 0  # the job (seq -1: idle) held `core` over [start, end)
+TRACE_MISS = 1   # the job missed its deadline, start = end = deadline
+
+# Job types, as in task_ali.cpp
+TYPE_NAMES = {0: "P", 1: "D", 2: "A"}
+
+COLUMNS = [
+    ("start", "i8"), ("end", "i8"), ("seq", "i8"), ("deadline", "i8"),
+    ("task", "i4"), ("core", "i4"), ("kind", "u1"), ("type", "u1"),
+]
+
+# Native byte order, like the files (the version check catches the other)
+HEADER_DTYPE = np.dtype([
+    ("magic", "S8"), ("version", "=u4"), ("rows_per_group", "=u4"),
+    ("rows", "=i8"), ("resolution", "=i8"), ("cores", "=i4"),
+    ("reserved", "=i4"), ("scheduler", "S88"),
+])
+
+
+class TraceError(Exception):
+    """The file is not a finished trace this reader understands"""
+
+
+@dataclass
+class Trace:
+    """One run's trace: 1-D column arrays, times in ticks"""
+    scheduler: str
+    resolution: int
+    cores: int
+    rows: int
+    columns: Dict[str, np.ndarray]
+
+    def __getitem__(self, name):
+        return self.columns[name]
+
+    def times(self, name):
+        """A time column in time units of the input"""
+        return self.columns[name] / self.resolution
+
+    def slices(self):
+        """Boolean mask of the execution slices (as opposed to misses)"""
+        return self.columns["kind"] == TRACE_SLICE
+
+    def misses(self):
+        """Boolean mask of the deadline misses"""
+        return self.columns["kind"] == TRACE_MISS
+
+
+def _group_dtype(rows: int) -> np.dtype:
+    return np.dtype([(name, "=" + kind, (rows,)) for name, kind in COLUMNS])
+
+
+def read_trace(path: str) -> Trace:
+    """
+    Maps a trace file. Columns of a trace that fits one row group are views
+    of the mapping; longer traces are stitched together from the per-group
+    views, which copies the values but still parses nothing.
+    """
+    header = np.fromfile(path, dtype=HEADER_DTYPE, count=1)
+    if header.size == 0 or header["magic"][0] != TRACE_MAGIC:
+        raise TraceError(f"{path}: not a trace file")
+    header = header[0]
+    if header["version"] != TRACE_VERSION:
+        raise TraceError(f"{path}: trace of another version or byte order")
+    rows = int(header["rows"])
+    if rows < 0:
+        raise TraceError(f"{path}: the run writing this trace did not finish")
+
+    group_rows = int(header["rows_per_group"])
+    full, rest = divmod(rows, group_rows)
+    offset = HEADER_DTYPE.itemsize
+    # One record per group; a column of a record is a plain array
+    parts = []
+    if full > 0:
+        full_dtype = _group_dtype(group_rows)
+        parts.append(np.memmap(path, dtype=full_dtype, mode="r", offset=offset, shape=(full,)))
+        offset += full * full_dtype.itemsize
+    if rest > 0:
+        parts.append(np.memmap(path, dtype=_group_dtype(rest), mode="r", offset=offset, shape=(1,)))
+
+    columns = {}
+    for name, kind in COLUMNS:
+        # (groups, rows) view of the column in each part
+        views = [part[name] for part in parts]
+        if len(views) == 1 and len(views[0]) == 1:
+            columns[name] = views[0][0]
+        elif views:
+            columns[name] = np.concatenate([view.reshape(-1) for view in views])
+        else:
+            columns[name] = np.zeros(0, dtype="=" + kind)
+
+    return Trace(
+        scheduler=header["scheduler"].split(b"\0")[0].decode(),
+        resolution=int(header["resolution"]),
+        cores=int(header["cores"]),
+        rows=rows,
+        columns=columns,
+    )
+
+
+def job_name(task: int, job_type: int) -> str:
+    """Label of a job in the text schedule, e.g. T1(P)"""
+    return f"T{task}({TYPE_NAMES.get(job_type, '?')})"
+
+
+def schedules_from_output(output: str) -> Dict[str, List[Tuple[float, str]]]:
+    """
+    Schedules of the uniprocessor runs whose traces run_ali reported on
+    "Trace: FILE" lines, keyed like the text sections ("<name> Scheduling"):
+    (start time, job) pairs in time order, as the text schedule lists them
+    """
+    schedules = {}
+    for line in output.splitlines():
+        if not line.startswith("Trace: "):
+            continue
+        trace = read_trace(line[len("Trace: "):].strip())
+        if trace.cores > 1:
+            continue
+        mask = trace.slices()
+        starts = trace.times("start")[mask]
+        seqs, tasks, types = trace["seq"][mask], trace["task"][mask], trace["type"][mask]
+        events = []
+        for start, seq, task, job_type in zip(starts.tolist(), seqs.tolist(), tasks.tolist(), types.tolist()):
+            time = int(start) if float(start).is_integer() else start
+            events.append((time, "IDLE" if seq < 0 else job_name(task, job_type)))
+        schedules[f"{trace.scheduler} Scheduling"] = events
+    return schedules
+
+
+def main():
+    """Prints a trace as a table, one row per line"""
+    if len(sys.argv) != 2:
+        print(f"Usage: python {sys.argv[0]} <trace_file>")
+        sys.exit(1)
+    trace = read_trace(sys.argv[1])
+    print(f"{trace.scheduler}: {trace.rows} rows, {trace.cores} core(s), {trace.resolution} ticks per time unit")
+    start, end = trace.times("start"), trace.times("end")
+    for i in range(trace.rows):
+        if trace["kind"][i] == TRACE_MISS:
+            print(f"{start[i]:g}\tmiss\t{job_name(trace['task'][i], trace['type'][i])}")
+            continue
+        who = "IDLE" if trace["seq"][i] < 0 else job_name(trace["task"][i], trace["type"][i])
+        core = f"\t{trace['core'][i]}" if trace.cores > 1 else ""
+        print(f"{start[i]:g}\t{end[i]:g}{core}\t{who}")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,274 +1,1083 @@
-#include "schedule_ali.cpp"
+#include "setup_ali.cpp"
+#include "runner_ali.cpp"
+#include "analysis_ali.cpp"
+#include "sensitivity_ali.cpp"
+#include "report_ali.cpp"
 #include <cmath>
 #include <vector>
 #include <memory>
 #include <algorithm>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <deque>
+#include <cstdlib>
+#include <fstream>
 
 extern "C" {
 #include "rts_parser.h"
+#include "rts_batch.h"
 }
 
 using namespace std;
 
-// Helper function to convert parsed tasks into C++ Task objects
-void loadTasksFromParser(ParserState* state, vector<shared_ptr<Task>>& tasks) {
-    tasks.clear();
-    for (int i = 0; i < state->task_count; i++) {
-        ParsedTask* p_task = &state->tasks[i];
-        TaskTypes type;
-        
-        // Map parser task type to C++ enum
-        if (p_task->type == PARSED_TASK_PERIODIC) {
-            type = Periodic;
-        } else if (p_task->type == PARSED_TASK_DYNAMIC) {
-            type = Dynamic;
-        } else { // PARSED_TASK_APERIODIC
-            type = Aperiodic;
-        }
+// Reported times are in time units of the input: ticks / resolution
 
-        tasks.push_back(make_shared<Task>(
-            type,
-            (double)p_task->execution_time,
-            (double)p_task->period,
-            (double)p_task->release_time,
-            (double)p_task->deadline
-        ));
+// Reports the final schedule and summary stats of a uniprocessor run (the
+// run of partitioned core `core`, if >= 0). With `until` set, the summary
+// also tells how far the run went and whether it stopped on a repeating
+// state. Runs with a limited-preemption mode or a switch cost also report
+// their preemptions and switches, against the `preemptive` ones of the fully
+// preemptive run if that is >= 0. Mixed-criticality runs report their mode
+// switches, and speed-scaled ones their energy against the `full_energy` of
+// the run at full speed.
+void reportSchedule(Scheduler* sch, Reporter& report, const SimResult& result, bool until, Tick resolution = 1,
+                    int core = -1, long preemptive = -1, double full_energy = 0) {
+    report.begin(sch->getName(), resolution, 1, core);
+    if (report.wantsEntries()) {
+        Span<TraceRecord> logs = sch->getLogs();
+        for (size_t i = 0; i < logs.size(); i++) {
+            // An idle start is not reported
+            if (i > 0 || logs[i].job.seq >= 0) report.entry(logs[i].start, logs[i].job, -1);
+        }
     }
+    RunSummary summary(sch->getFinishedCount(), sch->getMissedDeadlines());
+    summary.result = result;
+    summary.until = until;
+    const PreemptionConfig& preemption = sch->getPreemption();
+    summary.switching = preemption.limited() || preemption.switch_cost > 0;
+    summary.preemptive = preemptive;
+    summary.criticality = sch->mixedCriticality();
+    summary.energy = sch->getPlatform().scaling();
+    summary.full_energy = full_energy;
+    report.summary(summary);
 }
 
-// Prints the final schedule and summary stats
-void printSchedule(Scheduler* sch) {
-    cout << "\n=== " << sch->getName() << " Scheduling ===" << endl;
-    cout << "Time\tTask\tAction" << endl;
-    cout << "----\t----\t------" << endl;
+// Response-time statistics of one task in one run
+struct ResponseRow {
+    string file;
+    int set = 0;
+    string scheduler;
+    int task = 0;
+    TaskTypes type = Periodic;
+    long missed = 0;
+    ResponseStats stats; // in ticks
+    Tick resolution = 1;
+};
 
-    vector<tuple<double, Job*>> logs = sch->getLogs();
-    Job* prev_job = nullptr;
+// One row per task of `tasks` from a finished run of `sch`
+void collectResponseRows(const string& scheduler, Scheduler* sch, const vector<Task>& tasks,
+                         const ResponseRecorder& responses, Tick resolution, vector<ResponseRow>& rows) {
+    Span<JobRecord> missed = sch->getMissedDeadlines();
+    for (size_t i = 0; i < tasks.size(); i++) {
+        ResponseRow row;
+        row.scheduler = scheduler;
+        row.task = tasks[i].getId();
+        row.type = tasks[i].getType();
+        row.missed = count_if(missed.begin(), missed.end(), [&](const JobRecord& job) { return job.task_id == row.task; });
+        row.stats = responses.of(i);
+        row.resolution = resolution;
+        rows.push_back(move(row));
+    }
+}
 
-    for (const auto& log : logs) {
-        double time = get<0>(log);
-        Job* job = get<1>(log);
+// Writes response rows to the --stats file as they come in: CSV with a
+// header line, or a JSON array of objects. Statistics of tasks without a
+// completed job are empty (CSV) or null (JSON). Times are in time units.
+class ResponseWriter {
+private:
+    ofstream out;
+    bool json;
+    bool first = true;
 
-        if (job != prev_job) {
-            if (job == nullptr) {
-                cout << (int)(time + 0.5) << "\tIDLE\t-" << endl;
-            } else {
-                string type_str;
-                if (job->getTask()->getType() == Periodic) type_str = "(P)";
-                else if (job->getTask()->getType() == Dynamic) type_str = "(D)";
-                else type_str = "(A)";
-                
-                cout << time << "\tT" << job->getTask()->getId() << type_str
-                    << "\tExecuting (deadline: ";
-
-                if (job->getTask()->getType() == Aperiodic) {
-                    cout << "N/A";
-                    
-                } else {
-                    cout << std::fixed << std::setprecision(2) 
-                        << job->getAbsDeadline()
-                        << std::defaultfloat;    // reset formatting
-                }
+    void number(double value, const char* missing) {
+        if (std::isnan(value)) out << missing;
+        else out << value;
+    }
+
+public:
+    ResponseWriter(const string& filename, bool json) : out(filename), json(json) {
+        out.precision(10);
+        if (json) out << "[";
+        else out << "file,set,scheduler,task,type,completed,missed,min,mean,p50,p99,max,jitter\n";
+    }
 
-                cout << ")" << endl;
+    bool good() const { return (bool)out; }
 
+    void write(const ResponseRow& row) {
+        const ResponseStats& s = row.stats;
+        const char* type = row.type == Periodic ? "P" : row.type == Dynamic ? "D" : "A";
+        double values[] = {s.count ? s.min : NAN, s.mean(), s.percentile(0.5), s.percentile(0.99),
+                           s.count ? s.max : NAN, s.jitter()};
+        for (double& value : values) value /= row.resolution;
+        static const char* names[] = {"min", "mean", "p50", "p99", "max", "jitter"};
+        if (!json) {
+            out << row.file << "," << row.set + 1 << "," << row.scheduler << "," << row.task << "," << type << ","
+                << s.count << "," << row.missed;
+            for (double value : values) {
+                out << ",";
+                number(value, "");
             }
-            prev_job = job;
+            out << "\n";
+            return;
+        }
+        out << (first ? "\n" : ",\n") << "  {\"file\": \"";
+        for (char c : row.file) {
+            if (c == '"' || c == '\\') out << '\\';
+            out << c;
+        }
+        out << "\", \"set\": " << row.set + 1 << ", \"scheduler\": \"" << row.scheduler << "\", \"task\": " << row.task
+            << ", \"type\": \"" << type << "\", \"completed\": " << s.count << ", \"missed\": " << row.missed;
+        for (int k = 0; k < 6; k++) {
+            out << ", \"" << names[k] << "\": ";
+            number(values[k], "null");
         }
+        out << "}";
+        first = false;
     }
 
-    cout << "\nSummary:" << endl;
-    cout << "Completed jobs: " << sch->getFinishedJobs().size() << endl;
-    cout << "Missed deadlines: " << sch->getMissedDeadlines().size() << endl;
+    void write(const vector<ResponseRow>& rows) {
+        for (const ResponseRow& row : rows) write(row);
+    }
 
-    if (!sch->getMissedDeadlines().empty()) {
-        cout << "Deadline misses for tasks: ";
-        for (auto* job : sch->getMissedDeadlines()) {
-            cout << "T" << job->getTask()->getId() << " at t=" << job->getAbsDeadline() << " ";
-        }
-        cout << endl;
+    ~ResponseWriter() {
+        if (json) out << "\n]\n";
+    }
+};
+
+// Reports a snapshot that could not be read (the run did not happen) or
+// written, and the one a run left. Returns false if the run has
+// nothing to print.
+bool reportCheckpoint(const SimCheckpoint* checkpoint, const SimResult& result, ostream& out, Tick resolution) {
+    if (!checkpoint) return true;
+    if (!checkpoint->error.empty()) {
+        bool resuming = !checkpoint->resume_from.empty() && !checkpoint->resumed;
+        const string& path = resuming ? checkpoint->resume_from : checkpoint->save_to;
+        cerr << "Error: Snapshot '" << path << "': " << checkpoint->error << endl;
+        if (resuming) return false;
+    }
+    if (checkpoint->saved) {
+        out << "Snapshot at t=" << (double)result.end / resolution << ": " << checkpoint->save_to << endl;
     }
-    cout << endl;
+    return true;
+}
+
+// Starts the --trace-out file of a run; false if there is none or it cannot
+// be created
+bool openTrace(TraceExport& trace, const string& path, const string& scheduler, Tick resolution, int cores = 1) {
+    if (path.empty()) return false;
+    string error = trace.open(path, scheduler, resolution, cores);
+    if (error.empty()) return true;
+    cerr << "Error: Trace '" << path << "': " << error << endl;
+    return false;
+}
+
+void closeTrace(TraceExport& trace, ostream& out) {
+    string error = trace.close();
+    if (error.empty()) out << "Trace: " << trace.filename() << endl;
+    else cerr << "Error: Trace '" << trace.filename() << "': " << error << endl;
+}
+
+// Applies the preemption settings of a run to `sch`: policies without
+// limited-preemption modes (all but RM, DM, EDF, EDF-VD and AMC) stay fully
+// preemptive and only pay the switch cost
+void configurePreemption(Scheduler* sch, const PreemptionConfig& preemption, Tick resolution) {
+    PreemptionConfig config = preemption;
+    if (!sch->supportsLimitedPreemption()) config.mode = FULLY_PREEMPTIVE;
+    sch->setPreemption(config, resolution);
 }
 
-// Simulation for periodic-only schedulers (RM, EDF, LLF)
-void runPeriodicSimulation(const string& name, const vector<shared_ptr<Task>>& tasks, double sim_length) {
-    cout << "\n--- Running Periodic Simulation: " << name << " ---" << endl;
+// Preemptions the fully preemptive run of `name` (same switch cost) has over
+// the time a finished limited-preemption run of `sch` covered, or -1 if that
+// run was fully preemptive itself
+long fullyPreemptive(Scheduler* sch, const string& name, const vector<Task>& tasks, const SimHorizon& horizon,
+                     double llf_quantum, const SimResult& result) {
+    if (!sch->getPreemption().limited()) return -1;
+    Scheduler* full = makePeriodicScheduler(name, max<Tick>(horizon.ticks(llf_quantum), 1));
+    PreemptionConfig config;
+    config.switch_cost = sch->getPreemption().switch_cost;
+    full->setPreemption(config, horizon.resolution);
+    full->setPlatform(sch->getPlatform());
+    SimHorizon span = horizon;
+    span.length = result.end;
+    span.hyperperiod = 0;
+    long preemptions = simulate(full, tasks, span, false).preemptions;
+    delete full;
+    return preemptions;
+}
+
+// Energy the run of `name` (same preemption settings) takes at full speed
+// over the time a finished speed-scaled run of `sch` covered, or 0 if that
+// run was not scaled
+double fullSpeedEnergy(Scheduler* sch, const string& name, const vector<Task>& tasks, const SimHorizon& horizon,
+                       double llf_quantum, const SimResult& result) {
+    PlatformConfig platform = sch->getPlatform();
+    if (!platform.scaling()) return 0;
+    Scheduler* full = makePeriodicScheduler(name, max<Tick>(horizon.ticks(llf_quantum), 1));
+    full->setPreemption(sch->getPreemption(), horizon.resolution);
+    platform.dvfs = DVFS_STATIC;
+    platform.speed = 1;
+    full->setPlatform(platform);
+    SimHorizon span = horizon;
+    span.length = result.end;
+    span.hyperperiod = 0;
+    double energy = simulate(full, tasks, span, false).energy;
+    delete full;
+    return energy;
+}
+
+// Simulation for periodic-only schedulers (RM, EDF, LLF, EDF-VD, AMC)
+// With `rows` set, the per-task response times of the run are appended to it.
+// With `checkpoint` set, the run resumes from and stops into snapshots.
+// With `trace_path` set, the trace is also streamed to that trace file.
+// `platform` sets the criticality overruns and the speed scaling.
+// The schedule goes to `report`, the rest of the run's output to `out`.
+void runPeriodicSimulation(const string& name, const vector<Task>& tasks, const SimHorizon& horizon, ostream& out,
+                           Reporter& report, double llf_quantum = 1, vector<ResponseRow>* rows = nullptr,
+                           SimCheckpoint* checkpoint = nullptr, const string& trace_path = "",
+                           const PreemptionConfig& preemption = PreemptionConfig(),
+                           const PlatformConfig& platform = PlatformConfig()) {
+    out << "\n--- Running Periodic Simulation: " << name << " ---" << endl;
     
-    Scheduler* sch = nullptr;
-    if (name == "RM") sch = new RMScheduling();
-    else if (name == "EDF") sch = new EDFScheduling();
-    else if (name == "LLF") sch = new LLFScheduling();
-    else if (name == "DM") sch = new DMScheduling();
-    else {
+    Scheduler* sch = makePeriodicScheduler(name, max<Tick>(horizon.ticks(llf_quantum), 1));
+    if (!sch) {
         cerr << "Unknown periodic scheduler type." << endl;
         return;
     }
+    configurePreemption(sch, preemption, horizon.resolution);
+    sch->setPlatform(platform);
 
-    vector<Job> all_jobs;
-    all_jobs.reserve(1000);
-    vector<Job*> queued_jobs;
+    TraceExport trace;
+    bool tracing = openTrace(trace, trace_path, sch->getName(), horizon.resolution);
+    if (tracing) sch->exportTrace(&trace);
+    ResponseRecorder responses;
+    // A snapshot always carries the response times, whichever piece asks for them
+    SimResult result = simulate(sch, tasks, horizon, false, rows || checkpoint ? &responses : nullptr, checkpoint);
+    sch->finishTrace();
+    if (!reportCheckpoint(checkpoint, result, out, horizon.resolution)) {
+        delete sch;
+        return;
+    }
+    if (tracing) closeTrace(trace, out);
+    if (EDFVDScheduling* vd = dynamic_cast<EDFVDScheduling*>(sch)) {
+        out << "Virtual deadline factor: " << vd->virtualDeadlineFactor() << " (EDF-VD test "
+            << (vd->passesTest() ? "passed" : "failed") << ")" << endl;
+    }
 
-    while (sch->getCurrentTime() < sim_length) {
-        double current_time = sch->getCurrentTime();
+    bool until = horizon.hyperperiod > 0 || horizon.clamped || result.checkpointed;
+    long preemptive = fullyPreemptive(sch, name, tasks, horizon, llf_quantum, result);
+    double full_energy = fullSpeedEnergy(sch, name, tasks, horizon, llf_quantum, result);
+    reportSchedule(sch, report, result, until, horizon.resolution, -1, preemptive, full_energy);
+    if (rows) collectResponseRows(name, sch, tasks, responses, horizon.resolution, *rows);
+    delete sch;
+}
 
-        // Release new jobs for periodic tasks
-        for (const auto& task : tasks) {
-            if (task->getType() == Periodic || task->getType() == Dynamic) {
-                 if (fmod(current_time, task->getP()) < 0.01 && current_time >= task->getR()) {
-                    all_jobs.emplace_back(task, current_time);
-                    queued_jobs.push_back(&all_jobs.back());
-                }
-            }
-        }
+// Simulation for aperiodic server-based schedulers; of `preemption`, only
+// the switch cost applies
+void runAperiodicSimulation(const vector<Task>& tasks, const SimHorizon& horizon, const ParsedServerConfig& server_config,
+                            ostream& out, Reporter& report, vector<ResponseRow>* rows = nullptr,
+                            SimCheckpoint* checkpoint = nullptr, const string& trace_path = "",
+                            const PreemptionConfig& preemption = PreemptionConfig()) {
+    if (server_config.type == SERVER_NONE) {
+        cerr << "Cannot run aperiodic simulation without a server defined." << endl;
+        return;
+    }
+    ParsedServerConfig config = server_config;
+    // BACKGROUND sets have always been simulated as deferrable servers
+    if (config.type == SERVER_BACKGROUND) config.type = SERVER_DEFERRABLE;
+    Scheduler* sch = makeServerScheduler(config, horizon.resolution);
+    configurePreemption(sch, preemption, horizon.resolution);
+    
+    out << "\n--- Running Aperiodic Simulation: " << sch->getName() << " ---" << endl;
 
-        // Check for deadline misses
-        for (auto it = queued_jobs.begin(); it != queued_jobs.end();) {
-            if ((*it)->getAbsDeadline() <= current_time) {
-                sch->addMissedDeadline(*it);
-                it = queued_jobs.erase(it);
-            } else {
-                it++;
+    TraceExport trace;
+    bool tracing = openTrace(trace, trace_path, sch->getName(), horizon.resolution);
+    if (tracing) sch->exportTrace(&trace);
+    ResponseRecorder responses;
+    // A snapshot always carries the response times, whichever piece asks for them
+    SimResult result = simulate(sch, tasks, horizon, true, rows || checkpoint ? &responses : nullptr, checkpoint);
+    sch->finishTrace();
+    if (!reportCheckpoint(checkpoint, result, out, horizon.resolution)) {
+        delete sch;
+        return;
+    }
+    if (tracing) closeTrace(trace, out);
+
+    bool until = horizon.hyperperiod > 0 || horizon.clamped || result.checkpointed;
+    reportSchedule(sch, report, result, until, horizon.resolution);
+    if (rows) collectResponseRows(sch->getName(), sch, tasks, responses, horizon.resolution, *rows);
+    delete sch;
+}
+
+// Command-line settings shared by every run
+struct RunOptions {
+    int threads = 1;
+    double fixed_length = 0; // 0 = derive the horizon from the hyperperiod
+    Tick resolution = 1;     // ticks per time unit
+    bool analysis = false;   // try the analytical tests before simulating
+    double llf_quantum = 1;  // minimum time an LLF job runs once dispatched
+    int only_set = 0;        // 1-based set of each input to run, 0 = all
+    int cpus = 1;            // cores for the periodic schedulers
+    bool partitioned = false; // partitioned instead of global multiprocessor runs
+    PackingHeuristic packing = FIRST_FIT;
+    string stats_file;       // per-task response-time statistics go here, if set
+    bool stats_json = false; // ... as JSON instead of CSV
+    string checkpoint;       // snapshot prefix runs stop into at checkpoint_at, if set
+    double checkpoint_at = 0;
+    string resume;           // snapshot prefix runs continue from, if set
+    bool sensitivity = false; // search how far each run can be pushed instead of simulating it
+    double precision = 0.001; // of the critical scaling factor
+    double aperiodic_bound = 0; // response time a served request may take, 0 = any
+    string trace_out;        // binary trace file prefix, if set
+    string report_file;      // schedules are also reported here, if set
+    ReportFormat report_format = REPORT_CSV;
+    bool summary_only = false; // reports leave out the schedule lines
+    double overrun_at = -1;  // HI-criticality jobs overrun from this time on, < 0 = never
+    DvfsPolicy dvfs = DVFS_NONE; // speed scaling of the uniprocessor periodic runs
+    vector<double> speeds{1.0}; // available speeds, ascending, the last one 1
+    double static_power = 0.1;
+    PreemptionMode preemption = FULLY_PREEMPTIVE; // of the RM, DM, EDF, EDF-VD and AMC uniprocessor runs
+    int threshold_levels = 0; // preemption threshold above each task's level
+    double deferral = 0;     // deferred preemption region, in time units
+    double switch_cost = 0;  // context switch overhead, in time units
+};
+
+// Preemption settings of the runs over `horizon`
+PreemptionConfig preemptionFor(const RunOptions& options, const SimHorizon& horizon) {
+    PreemptionConfig config;
+    config.mode = options.preemption;
+    config.threshold_levels = options.threshold_levels;
+    config.deferral = horizon.ticks(options.deferral);
+    config.switch_cost = horizon.ticks(options.switch_cost);
+    return config;
+}
+
+// Platform of uniprocessor periodic run `name` over `horizon`. Cycle-conserving
+// scaling only applies to EDF; the other policies scale statically, to
+// the lowest speed the tests accept, which is reported on `out`.
+PlatformConfig platformFor(const RunOptions& options, const SimHorizon& horizon, const ParserState& state,
+                           const string& name, ostream& out) {
+    PlatformConfig platform;
+    if (options.overrun_at >= 0) platform.overrun_at = horizon.ticks(options.overrun_at);
+    platform.dvfs = options.dvfs;
+    platform.speeds = options.speeds;
+    platform.static_power = options.static_power;
+    if (platform.dvfs == DVFS_CYCLE_CONSERVING && name != "EDF") platform.dvfs = DVFS_STATIC;
+    if (platform.dvfs == DVFS_STATIC) {
+        string test;
+        platform.speed = staticSpeed(&state, name, platform.speeds, test);
+        out << "\n--- Static speed: " << name << " ---" << endl;
+        out << name << ": speed " << platform.speed;
+        if (!test.empty()) out << " (" << test << ")";
+        else out << " (no test accepts a lower one)";
+        out << endl;
+    }
+    return platform;
+}
+
+// Snapshot file of one uniprocessor run: <prefix>.<input>.<set>.<run>.snap,
+// with the input's base name, the 1-based set and the scheduler, or
+// "server" for a server run
+string snapshotPath(const string& prefix, const string& run_name, const string& scheduler) {
+    return prefix + "." + run_name + "." + scheduler + ".snap";
+}
+
+// Binary trace file of one run, named like its snapshot:
+// <prefix>.<input>.<set>.<run>.trace
+string tracePath(const string& prefix, const string& run_name, const string& scheduler) {
+    return prefix + "." + run_name + "." + scheduler + ".trace";
+}
+
+// Name under which a set's runs keep their snapshots and traces
+string runName(const string& filename, int set) {
+    size_t slash = filename.find_last_of("/\\");
+    return filename.substr(slash == string::npos ? 0 : slash + 1) + "." + to_string(set + 1);
+}
+
+// Snapshot settings of one run, or false if it takes none
+bool checkpointFor(const RunOptions& options, const SimHorizon& horizon, const string& run_name,
+                   const string& scheduler, SimCheckpoint& checkpoint) {
+    if (options.checkpoint.empty() && options.resume.empty()) return false;
+    if (!options.resume.empty()) checkpoint.resume_from = snapshotPath(options.resume, run_name, scheduler);
+    if (!options.checkpoint.empty()) {
+        checkpoint.save_to = snapshotPath(options.checkpoint, run_name, scheduler);
+        checkpoint.stop_at = horizon.ticks(options.checkpoint_at);
+    }
+    return true;
+}
+
+
+// Busy fraction of every core over its simulated time
+void printCoreUtilization(const vector<Tick>& busy, const vector<Tick>& ends, ostream& out) {
+    out << "Core utilization:";
+    for (size_t c = 0; c < busy.size(); c++) {
+        out << " " << c << ": " << (ends[c] > 0 ? (double)busy[c] / ends[c] : 0);
+    }
+    out << endl;
+}
+
+// Time a uniprocessor trace spent executing
+Tick busyTime(Span<TraceRecord> trace) {
+    Tick busy = 0;
+    for (const auto& record : trace) {
+        if (record.job.seq >= 0) busy += record.end - record.start;
+    }
+    return busy;
+}
+
+// Global scheduling: all cores share one ready queue
+void runGlobalSimulation(const string& name, const vector<Task>& tasks, const SimHorizon& horizon,
+                         const RunOptions& options, ostream& out, Reporter& report, vector<ResponseRow>* rows,
+                         const string& trace_path = "") {
+    int m = options.cpus;
+    out << "\n--- Running Global Simulation: " << name << " on " << m << " cores ---" << endl;
+    Scheduler* sch = makePeriodicScheduler(name, max<Tick>(horizon.ticks(options.llf_quantum), 1));
+    if (!sch->supportsGlobal()) {
+        out << name << ": no global variant, simulation skipped" << endl;
+        delete sch;
+        return;
+    }
+    TraceExport trace;
+    bool tracing = openTrace(trace, trace_path, "Global " + sch->getName(), horizon.resolution, m);
+    ResponseRecorder responses;
+    MulticoreResult result = simulateGlobal(sch, tasks, horizon, m, rows ? &responses : nullptr,
+                                            tracing ? &trace : nullptr);
+    if (tracing) closeTrace(trace, out);
+
+    report.begin("Global " + sch->getName(), horizon.resolution, m);
+    if (report.wantsEntries()) {
+        // Merge the per-core traces by start time; an idle start is not reported
+        vector<tuple<Tick, int, size_t>> entries;
+        for (int c = 0; c < m; c++) {
+            const vector<TraceRecord>& trace = result.traces[c];
+            for (size_t i = 0; i < trace.size(); i++) {
+                if (i > 0 || trace[i].job.seq >= 0) entries.push_back({trace[i].start, c, i});
             }
         }
-        
-        // Select and execute job
-        Job* now = sch->selectTask(queued_jobs);
-        if (now) {
-            now->execute(1.0);
-            sch->addLog(now);
-
-            if (now->isComplete()) {
-                queued_jobs.erase(remove(queued_jobs.begin(), queued_jobs.end(), now), queued_jobs.end());
-                sch->addFinishedJob(now);
-            }
-        } else {
-            sch->addLog(nullptr); // Log IDLE time
+        sort(entries.begin(), entries.end());
+        for (const auto& entry : entries) {
+            int c = get<1>(entry);
+            report.entry(get<0>(entry), result.traces[c][get<2>(entry)].job, c);
         }
-        sch->clockTick(1.0);
     }
 
-    printSchedule(sch);
+    RunSummary summary(sch->getFinishedCount(), sch->getMissedDeadlines());
+    summary.result = result.sim;
+    summary.until = horizon.hyperperiod > 0 || horizon.clamped;
+    summary.migrations = result.migrations;
+    summary.busy = result.busy;
+    summary.ends.assign(m, result.sim.end);
+    report.summary(summary);
+    if (rows) collectResponseRows("Global " + name, sch, tasks, responses, horizon.resolution, *rows);
     delete sch;
 }
 
-// Simulation for aperiodic server-based schedulers
-void runAperiodicSimulation(const vector<shared_ptr<Task>>& tasks, double sim_length, const ParsedServerConfig& server_config) {
-    Scheduler* sch = nullptr;
-    if (server_config.type == SERVER_POLLER) {
-        sch = new PollerScheduling((double)server_config.period, (double)server_config.budget, server_config.scheduling);
-    } else if (server_config.type == SERVER_DEFERRABLE) {
-        sch = new DeferableScheduling((double)server_config.period, (double)server_config.budget, server_config.scheduling);
-    } 
-    else if (server_config.type == SERVER_BACKGROUND) {
-        sch = new DeferableScheduling((double)server_config.period, (double)server_config.budget, server_config.scheduling);
-    } else {
-        cerr << "Cannot run aperiodic simulation without a server defined." << endl;
+// Partitioned scheduling: tasks are bin-packed onto the cores, then every
+// core runs the policy on its own tasks
+void runPartitionedSimulation(const string& name, const vector<Task>& tasks, const SimHorizon& horizon,
+                              const RunOptions& options, ostream& out, Reporter& report, vector<ResponseRow>* rows,
+                              const string& trace_path = "") {
+    int m = options.cpus;
+    out << "\n--- Running Partitioned Simulation: " << name << " on " << m << " cores ("
+        << packingName(options.packing) << ") ---" << endl;
+    vector<vector<size_t>> cores;
+    vector<double> load;
+    vector<size_t> unplaced = partitionTasks(tasks, m, name, options.packing, cores, load);
+
+    streamsize saved_precision = out.precision(15);
+    for (int c = 0; c < m; c++) {
+        out << "Core " << c << ":";
+        for (size_t i : cores[c]) out << " T" << tasks[i].getId();
+        out << " (U = " << load[c] << ")" << endl;
+    }
+    if (!unplaced.empty()) {
+        out << "Partitioning failed, no core can take:";
+        for (size_t i : unplaced) out << " T" << tasks[i].getId();
+        out << endl << name << ": not schedulable (partitioning), simulation skipped" << endl;
+        out.precision(saved_precision);
         return;
     }
-    
-    cout << "\n--- Running Aperiodic Simulation: " << sch->getName() << " ---" << endl;
-
-    vector<Job> all_jobs;
-    all_jobs.reserve(1000);
-    vector<Job*> queued_jobs;
-    vector<bool> aperiodic_released(tasks.size(), false);
-
-    while (sch->getCurrentTime() < sim_length) {
-        double current_time = sch->getCurrentTime();
-
-        // Release jobs
-        for (size_t i = 0; i < tasks.size(); ++i) {
-            const auto& task = tasks[i];
-            bool should_release = false;
-            if (task->getType() == Periodic || task->getType() == Dynamic) {
-                if (fmod(current_time, task->getP()) < 0.01 && current_time >= task->getR()) {
-                    should_release = true;
-                }
-            } else if (task->getType() == Aperiodic) {
-                if (!aperiodic_released[i] && fabs(current_time - task->getR()) < 0.01) {
-                    should_release = true;
-                    aperiodic_released[i] = true;
-                }
-            }
 
-            if (should_release) {
-                all_jobs.emplace_back(task, current_time);
-                queued_jobs.push_back(&all_jobs.back());
-            }
+    // One trace for all cores, each core's slices marked with it
+    TraceExport trace;
+    bool tracing = openTrace(trace, trace_path, "Partitioned " + name, horizon.resolution, m);
+    long completed = 0, missed = 0;
+    vector<Tick> busy(m, 0), ends(m, 0);
+    for (int c = 0; c < m; c++) {
+        if (cores[c].empty()) continue;
+        vector<Task> core_tasks;
+        for (size_t i : cores[c]) core_tasks.push_back(tasks[i]);
+        Scheduler* sch = makePeriodicScheduler(name, max<Tick>(horizon.ticks(options.llf_quantum), 1));
+        configurePreemption(sch, preemptionFor(options, horizon), horizon.resolution);
+        if (tracing) sch->exportTrace(&trace, c);
+        ResponseRecorder responses;
+        SimResult result = simulate(sch, core_tasks, horizon, false, rows ? &responses : nullptr);
+        sch->finishTrace();
+        out << "\n--- Core " << c << " ---" << endl;
+        long preemptive = fullyPreemptive(sch, name, core_tasks, horizon, options.llf_quantum, result);
+        reportSchedule(sch, report, result, horizon.hyperperiod > 0 || horizon.clamped, horizon.resolution, c,
+                       preemptive);
+        if (rows) collectResponseRows("Partitioned " + name, sch, core_tasks, responses, horizon.resolution, *rows);
+        completed += sch->getFinishedCount();
+        missed += sch->getMissedDeadlines().size();
+        busy[c] = busyTime(sch->getLogs());
+        ends[c] = result.end;
+        delete sch;
+    }
+
+    out << "=== Partitioned " << name << " Summary ===" << endl;
+    out << "Completed jobs: " << completed << endl;
+    out << "Missed deadlines: " << missed << endl;
+    out << "Migrations: 0" << endl;
+    printCoreUtilization(busy, ends, out);
+    if (tracing) closeTrace(trace, out);
+    out.precision(saved_precision);
+    out << endl;
+}
+
+// Simulation length: a fixed number of time units, or 0 to derive it from
+// the task set's hyperperiod
+SimHorizon horizonFor(const ParserState& state, double fixed_length, Tick resolution) {
+    if (fixed_length > 0) {
+        SimHorizon horizon(0, resolution);
+        horizon.length = horizon.ticks(fixed_length);
+        return horizon;
+    }
+    SimHorizon horizon = computeHorizon(&state, HORIZON_LIMIT, resolution);
+    if (horizon.clamped) {
+        cerr << "Warning: hyperperiod exceeds " << (long long)HORIZON_LIMIT
+             << " time units, simulating only up to the limit" << endl;
+    }
+    return horizon;
+}
+
+// Number of scheduler runs a file gets: a set with HI-criticality tasks
+// also runs the mixed-criticality policies, except in the sensitivity search
+int runsFor(const ParserState& state, const RunOptions& options) {
+    if (state.server.type != SERVER_NONE) return 1;
+    return hasHiCriticality(state) && !options.sensitivity ? 6 : 4;
+}
+
+// Name of periodic run `r` (see runsFor)
+const char* periodicScheduler(int r) {
+    return r < 4 ? PERIODIC_SCHEDULERS[r] : MIXED_CRITICALITY_SCHEDULERS[r - 4];
+}
+
+// One line of sensitivity results: `what` followed by the value found
+void printSensitivity(ostream& out, const string& what, const SensitivityResult& result, int digits) {
+    ios::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+    out << what << ": " << fixed << setprecision(digits) << result.value;
+    out.flags(flags);
+    out.precision(precision);
+    out << " (" << result.probes << " probes, " << result.simulated << " simulated";
+    if (!result.decided_by.empty()) out << ", last feasible one by " << result.decided_by;
+    out << ")";
+    if (result.clamped) out << ", simulated only up to t=" << (long long)HORIZON_LIMIT;
+    out << endl;
+}
+
+// Sensitivity mode for run `r` of a set: the critical scaling factor of a
+// periodic policy, or the feasible budget range of a polling or deferrable
+// server
+void runSensitivity(const ParserState& state, const RunOptions& options, int r, ostream& out) {
+    if (state.server.type != SERVER_NONE) {
+        // BACKGROUND sets run as deferrable servers, as in runAperiodicSimulation
+        ParserState server_state = state;
+        if (server_state.server.type == SERVER_BACKGROUND) server_state.server.type = SERVER_DEFERRABLE;
+        out << "\n--- Sensitivity: server budget ---" << endl;
+        if (server_state.server.type != SERVER_POLLER && server_state.server.type != SERVER_DEFERRABLE) {
+            out << "Budget search only applies to polling and deferrable servers" << endl;
+            return;
         }
+        BudgetRange range = serverBudgetRange(&server_state, options.resolution, options.aperiodic_bound);
+        int digits = (int)ceil(log10((double)options.resolution));
+        if (range.smallest.value < 0) out << "No budget up to the server period serves every request" << endl;
+        else printSensitivity(out, "Smallest budget serving every request", range.smallest, digits);
+        if (range.largest.value < 0) out << "No budget keeps every periodic deadline" << endl;
+        else printSensitivity(out, "Largest budget meeting every periodic deadline", range.largest, digits);
+        return;
+    }
+    const char* name = PERIODIC_SCHEDULERS[r];
+    out << "\n--- Sensitivity: " << name << " ---" << endl;
+    SensitivityResult result = criticalScaling(&state, name, options.resolution, options.precision, options.llf_quantum);
+    if (!result.bounded) {
+        out << name << ": no periodic work to scale" << endl;
+        return;
+    }
+    if (result.value == 0 && result.probes == 1) {
+        out << name << ": not schedulable even with the shortest execution times" << endl;
+        return;
+    }
+    printSensitivity(out, name + string(" critical scaling factor"), result,
+                     max((int)ceil(-log10(options.precision)), 0));
+}
 
-        // Check for deadline misses (only for non-aperiodic tasks)
-        for (auto it = queued_jobs.begin(); it != queued_jobs.end();) {
-            if ((*it)->getTask()->getType() != Aperiodic && (*it)->getAbsDeadline() <= current_time) {
-                sch->addMissedDeadline(*it);
-                it = queued_jobs.erase(it);
-            } else {
-                it++;
+// Run `r` of a file: one of the periodic schedulers, or its server. With
+// analysis enabled a periodic run is only simulated when the tests are
+// inconclusive. Simulated runs append their response rows to `rows`, if set.
+// Uniprocessor runs keep their snapshots under `run_name` (see runName), and
+// every simulated run its --trace-out file. Schedules are printed on `out`
+// and, with `records` set, also reported there.
+void runScheduler(const ParserState& state, const vector<Task>& tasks, const SimHorizon& horizon,
+                  const RunOptions& options, int r, const string& run_name, ostream& out = cout,
+                  vector<ResponseRow>* rows = nullptr, Reporter* records = nullptr) {
+    if (options.sensitivity) {
+        runSensitivity(state, options, r, out);
+        return;
+    }
+    SimCheckpoint checkpoint;
+    bool server = state.server.type != SERVER_NONE;
+    const char* name = server ? "server" : periodicScheduler(r);
+    string trace_path = options.trace_out.empty() ? "" : tracePath(options.trace_out, run_name, name);
+    TextReporter text(out, options.summary_only);
+    ReportTee report(text, records);
+    if (server) {
+        // A server is defined, run the appropriate aperiodic simulation
+        bool snapshots = checkpointFor(options, horizon, run_name, name, checkpoint);
+        runAperiodicSimulation(tasks, horizon, state.server, out, report, rows, snapshots ? &checkpoint : nullptr, trace_path,
+                               preemptionFor(options, horizon));
+        return;
+    }
+    if (options.cpus > 1) {
+        if (options.partitioned) runPartitionedSimulation(name, tasks, horizon, options, out, report, rows, trace_path);
+        else runGlobalSimulation(name, tasks, horizon, options, out, report, rows, trace_path);
+        return;
+    }
+    PreemptionConfig preemption = preemptionFor(options, horizon);
+    bool overruns = options.overrun_at >= 0 && hasHiCriticality(state);
+    // The tests assume fully preemptive scheduling without overhead, at full
+    // speed, with every job at its LO execution time
+    if (options.analysis && !preemption.limited() && preemption.switch_cost == 0 && options.dvfs == DVFS_NONE &&
+        !overruns && r < 4) {
+        Analysis result = analyzeSchedulability(&state, name);
+        if (result.verdict != UNDECIDED) {
+            out << "\n--- Analysis: " << name << " ---" << endl;
+            out << name << ": " << (result.verdict == SCHEDULABLE ? "schedulable" : "not schedulable")
+                << " (" << result.test << "), simulation skipped" << endl;
+            return;
+        }
+    }
+    bool snapshots = checkpointFor(options, horizon, run_name, name, checkpoint);
+    runPeriodicSimulation(name, tasks, horizon, out, report, options.llf_quantum, rows,
+                          snapshots ? &checkpoint : nullptr, trace_path, preemption,
+                          platformFor(options, horizon, state, name, out));
+}
+
+// Runs every scheduler that applies to one parsed file
+void runFile(const ParserState& state, const vector<Task>& tasks, const RunOptions& options, const string& run_name,
+             ostream& out = cout, vector<ResponseRow>* rows = nullptr, Reporter* records = nullptr) {
+    SimHorizon horizon = horizonFor(state, options.fixed_length, options.resolution);
+    for (int r = 0; r < runsFor(state, options); r++) {
+        runScheduler(state, tasks, horizon, options, r, run_name, out, rows, records);
+    }
+}
+
+// Labels rows produced for one task set with its file and set number
+void labelRows(vector<ResponseRow>& rows, const string& filename, int set) {
+    for (ResponseRow& row : rows) {
+        row.file = filename;
+        row.set = set;
+    }
+}
+
+// Banner in front of each task set's output; sets after the first one of a
+// multi-set file are numbered
+void printSetHeader(const string& filename, int set, ostream& out = cout) {
+    out << "\n\n========== Processing file: " << filename;
+    if (set > 0) out << " (set " << set + 1 << ")";
+    out << " ==========" << endl;
+}
+
+// Feeds the task sets of a text or batch file to `callback`, restricted to
+// --set if given
+int loadSets(const string& filename, const RunOptions& options, ParseSetCallback callback, void* user) {
+    if (options.only_set > 0) return load_sets(filename.c_str(), options.only_set - 1, 1, callback, user);
+    return load_sets(filename.c_str(), 0, -1, callback, user);
+}
+
+// Why loadSets() produced nothing, or "" if it did
+string loadError(const string& filename, const RunOptions& options, int sets) {
+    if (sets < 0) return "Error: Failed to parse file '" + filename + "'";
+    if (sets == 0 && options.only_set > 0) {
+        return "Error: No task set " + to_string(options.only_set) + " in file '" + filename + "'";
+    }
+    return "";
+}
+
+// Set whose banner comes first for each input
+int firstSet(const RunOptions& options) {
+    return options.only_set > 0 ? options.only_set - 1 : 0;
+}
+
+// A task set parsed for the parallel runner. Each simulation writes into
+// its own buffer and the main thread prints the buffers in input order, so
+// the output matches a serial run.
+struct ParsedFile {
+    string filename;
+    int set = 0;
+    bool ok = false;
+    string error; // when !ok
+    ParserState state;
+    vector<Task> tasks;
+    SimHorizon horizon;
+    vector<string> outputs;
+    vector<vector<ResponseRow>> rows; // per run, with --stats
+    vector<string> reports;           // per run, with --report
+    vector<bool> done;
+
+    ParsedFile() { init_parser_state(&state); }
+    ~ParsedFile() { free_parser_state(&state); }
+    ParsedFile(const ParsedFile&) = delete;
+    ParsedFile& operator=(const ParsedFile&) = delete;
+};
+
+// Shared by the parallel runner and its parse callback
+struct ParallelRun {
+    const RunOptions* options;
+    ResponseWriter* stats; // null without --stats
+    ReportFile* report;    // null without --report
+    WorkStealingPool* pool;
+    deque<ParsedFile> files; // deque: growing it never moves a set a task still uses
+    mutex results_lock;
+    condition_variable result_ready;
+    string filename;
+    int sets_in_file = 0;
+
+    // Parse callback: keeps the set and queues its simulations
+    static int addSet(ParserState* state, int set, void* user) {
+        ParallelRun* run = (ParallelRun*)user;
+        run->files.emplace_back();
+        ParsedFile& file = run->files.back();
+        file.filename = run->filename;
+        file.set = set;
+        file.ok = true;
+        take_parser_state(&file.state, state);
+        loadTasksFromParser(&file.state, file.tasks, run->options->resolution);
+        file.horizon = horizonFor(file.state, run->options->fixed_length, run->options->resolution);
+        run->sets_in_file++;
+
+        int runs = runsFor(file.state, *run->options);
+        file.outputs.assign(runs, string());
+        file.rows.assign(runs, vector<ResponseRow>());
+        file.reports.assign(runs, string());
+        file.done.assign(runs, false);
+        for (int r = 0; r < runs; r++) {
+            run->pool->submit([run, &file, r] {
+                ostringstream out, records;
+                vector<ResponseRow> rows;
+                unique_ptr<Reporter> reporter;
+                if (run->report) reporter = run->report->reporter(file.filename, file.set, &records);
+                runScheduler(file.state, file.tasks, file.horizon, *run->options, r,
+                             runName(file.filename, file.set), out, run->stats ? &rows : nullptr, reporter.get());
+                reporter.reset();
+                labelRows(rows, file.filename, file.set);
+                lock_guard<mutex> guard(run->results_lock);
+                file.outputs[r] = out.str();
+                file.rows[r].swap(rows);
+                file.reports[r] = records.str();
+                file.done[r] = true;
+                run->result_ready.notify_all();
+            });
+        }
+        return 0;
+    }
+};
+
+void runFilesParallel(const vector<string>& filenames, const RunOptions& options, ResponseWriter* stats,
+                      ReportFile* report) {
+    ParallelRun run;
+    run.options = &options;
+    run.stats = stats;
+    run.report = report;
+    {
+        WorkStealingPool pool(options.threads);
+        run.pool = &pool;
+        // Parse and load serially so task ids are assigned in file order
+        for (const string& filename : filenames) {
+            run.filename = filename;
+            run.sets_in_file = 0;
+            string error = loadError(filename, options, loadSets(filename, options, ParallelRun::addSet, &run));
+            if (!error.empty()) {
+                // Marks where the error goes in the output
+                run.files.emplace_back();
+                run.files.back().filename = filename;
+                run.files.back().set = run.sets_in_file == 0 ? firstSet(options) : -1;
+                run.files.back().error = error;
             }
         }
 
-        // Replenish server budget if applicable
-        sch->budgetReplenishment();
-
-        // Select and execute job
-        Job* now = sch->selectTask(queued_jobs);
-        if (now) {
-            sch->addLog(now);
-            sch->execute_server_version(now, 1.0); // Use virtual dispatch for execution
-            
-            if (now->isComplete()) {
-                queued_jobs.erase(remove(queued_jobs.begin(), queued_jobs.end(), now), queued_jobs.end());
-                sch->addFinishedJob(now);
+        // Stream results in input order while the pool keeps working
+        for (ParsedFile& file : run.files) {
+            if (!file.ok) {
+                if (file.set >= 0) printSetHeader(file.filename, file.set);
+                cerr << file.error << endl;
+                continue;
             }
-        } else {
-            sch->addLog(nullptr); // Log IDLE time
+            printSetHeader(file.filename, file.set);
+            print_tasks(&file.state);
+            print_server_config(&file.state);
+            for (size_t r = 0; r < file.outputs.size(); r++) {
+                string output, records;
+                vector<ResponseRow> rows;
+                {
+                    unique_lock<mutex> guard(run.results_lock);
+                    run.result_ready.wait(guard, [&] { return (bool)file.done[r]; });
+                    output.swap(file.outputs[r]);
+                    rows.swap(file.rows[r]);
+                    records.swap(file.reports[r]);
+                }
+                cout << output;
+                if (stats) stats->write(rows);
+                if (report) report->write(records);
+            }
+            cout.flush();
         }
-        sch->clockTick(1.0);
     }
-    
-    printSchedule(sch);
-    delete sch;
 }
 
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        cerr << "Usage: " << argv[0] << " <input_file_1> [input_file_2] ..." << endl;
-        return 1;
+// Serial runner: each set is simulated as soon as it is parsed and then
+// dropped, so a batch file never has to fit in memory
+struct SerialRun {
+    string filename;
+    const RunOptions* options;
+    ResponseWriter* stats; // null without --stats
+    ReportFile* report;    // null without --report
+
+    static int runSet(ParserState* state, int set, void* user) {
+        SerialRun* run = (SerialRun*)user;
+        if (set != firstSet(*run->options)) printSetHeader(run->filename, set);
+
+        print_tasks(state);
+        print_server_config(state);
+
+        vector<Task> tasks;
+        loadTasksFromParser(state, tasks, run->options->resolution);
+
+        vector<ResponseRow> rows;
+        unique_ptr<Reporter> reporter;
+        if (run->report) reporter = run->report->reporter(run->filename, set);
+        runFile(*state, tasks, *run->options, runName(run->filename, set), cout, run->stats ? &rows : nullptr,
+                reporter.get());
+        labelRows(rows, run->filename, set);
+        if (run->stats) run->stats->write(rows);
+        return 0;
     }
+};
 
-    cout << "Starting RTS Simulator..." << endl;
+// With RTS_INSTRUMENT, the counters of every simulation thread merged
+void printCounterTotals() {
+    if (!RTS_INSTRUMENT) return;
+    int threads = 0;
+    SimCounters total = allCounters(&threads);
+    OutBuffer out(cout);
+    out.put("\n=== Instrumentation (").integer(threads).put(threads == 1 ? " thread" : " threads").put(") ===\n");
+    writeCounters(out, total);
+}
 
+int main(int argc, char* argv[]) {
+    // -j N runs the simulations on N threads (0 = one per core)
+    // --horizon T simulates exactly T time units instead of the hyperperiod
+    // --resolution N counts time in ticks of 1/N time units (default 1, at
+    //   most RESOLUTION_LIMIT)
+    // --analysis skips simulations that the schedulability tests can decide
+    // --llf-quantum Q lets a dispatched LLF job run for at least Q time units
+    // --set N runs only the N-th task set of each input
+    // --cpus M runs the periodic schedulers on M cores (global scheduling;
+    //   server sets still run on one core)
+    // --partition ff|bf|wf switches to partitioned scheduling, packing tasks
+    //   first-, best- or worst-fit by decreasing utilization
+    // --stats FILE writes per-task response-time statistics (count, misses,
+    //   min/mean/p50/p99/max and jitter = max - min) of every simulated run
+    //   as CSV, or as JSON with --stats-format json
+    // --checkpoint PREFIX --checkpoint-at T stops every uniprocessor run at
+    //   its first event at or after T and saves its state to a snapshot file
+    //   (see snapshotPath); --resume PREFIX continues each run from its
+    //   snapshot, so a long run can be split into pieces
+    // --sensitivity replaces each simulation by a search for how far the run
+    //   can be pushed: the critical execution-time scaling factor of every
+    //   periodic policy (to --precision P), or the budget range of a polling
+    //   or deferrable server, where a request must complete within
+    //   --aperiodic-bound T of its release to count as served
+    // --trace-out PREFIX also streams the trace of every simulated run to a
+    //   columnar binary file (see tracePath and traceout_ali.cpp) for the
+    //   visualizers to map
+    // --report FILE also reports every schedule (each job start and idle
+    //   period, the deadline misses and the run's summary) to FILE as CSV, or
+    //   as JSON lines with --report-format jsonl
+    // --summary-only leaves the schedule lines out of the output and the
+    //   report, keeping only the summaries
+    // --preemption np|threshold:K|deferred:Q runs RM, DM, EDF, EDF-VD and
+    //   AMC non-preemptively, with preemption thresholds K levels above each
+    //   task's level, or with non-preemptive regions of Q time units
+    //   (default: full); the summaries then compare the preemptions with
+    //   those of the fully preemptive run
+    // --switch-cost C charges C time units to every context switch
+    // Sets with HI-criticality tasks ("HI ei_hi" after a periodic task) also
+    // run EDF-VD and AMC, which drop the LO tasks once a HI job overruns its
+    // LO execution time until the processor next idles:
+    // --overrun-at T makes every HI job released from T on run for its HI
+    //   execution time (default: none overruns)
+    // --dvfs static|cc scales the speed of the uniprocessor periodic runs, to
+    //   the lowest of --speeds a,b,... (ascending, default 1) the tests
+    //   accept, or cycle-conserving for EDF; the summaries then
+    //   report the energy (--static-power P plus speed^3 per time unit)
+    //   against that of running at full speed
+    RunOptions options;
+    vector<string> filenames;
     for (int i = 1; i < argc; ++i) {
-        const string filename = argv[i];
-        cout << "\n\n========== Processing file: " << filename << " ==========" << endl;
-
-        ParserState state;
-        if (parse_file(filename.c_str(), &state) < 0) {
-            cerr << "Error: Failed to parse file '" << filename << "'" << endl;
-            continue;
+        string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            options.threads = atoi(argv[++i]);
+            if (options.threads <= 0) options.threads = thread::hardware_concurrency();
+        } else if (arg == "--horizon" && i + 1 < argc) {
+            options.fixed_length = atof(argv[++i]);
+        } else if (arg == "--resolution" && i + 1 < argc) {
+            options.resolution = max(atoll(argv[++i]), 1LL);
+            if (options.resolution > RESOLUTION_LIMIT) {
+                cerr << "Warning: --resolution is capped at " << RESOLUTION_LIMIT << " ticks per time unit" << endl;
+                options.resolution = RESOLUTION_LIMIT;
+            }
+        } else if (arg == "--analysis") {
+            options.analysis = true;
+        } else if (arg == "--cpus" && i + 1 < argc) {
+            options.cpus = max(atoi(argv[++i]), 1);
+        } else if (arg == "--partition" && i + 1 < argc) {
+            string packing = argv[++i];
+            options.partitioned = true;
+            if (packing == "bf") options.packing = BEST_FIT;
+            else if (packing == "wf") options.packing = WORST_FIT;
+            else options.packing = FIRST_FIT;
+        } else if (arg == "--set" && i + 1 < argc) {
+            options.only_set = max(atoi(argv[++i]), 1);
+        } else if (arg == "--stats" && i + 1 < argc) {
+            options.stats_file = argv[++i];
+        } else if (arg == "--stats-format" && i + 1 < argc) {
+            options.stats_json = string(argv[++i]) == "json";
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            options.checkpoint = argv[++i];
+        } else if (arg == "--checkpoint-at" && i + 1 < argc) {
+            options.checkpoint_at = atof(argv[++i]);
+        } else if (arg == "--resume" && i + 1 < argc) {
+            options.resume = argv[++i];
+        } else if (arg == "--sensitivity") {
+            options.sensitivity = true;
+        } else if (arg == "--precision" && i + 1 < argc) {
+            options.precision = atof(argv[++i]);
+            if (options.precision <= 0) options.precision = 0.001;
+        } else if (arg == "--aperiodic-bound" && i + 1 < argc) {
+            options.aperiodic_bound = atof(argv[++i]);
+        } else if (arg == "--trace-out" && i + 1 < argc) {
+            options.trace_out = argv[++i];
+        } else if (arg == "--report" && i + 1 < argc) {
+            options.report_file = argv[++i];
+        } else if (arg == "--report-format" && i + 1 < argc) {
+            options.report_format = string(argv[++i]) == "jsonl" ? REPORT_JSONL : REPORT_CSV;
+        } else if (arg == "--summary-only") {
+            options.summary_only = true;
+        } else if (arg == "--preemption" && i + 1 < argc) {
+            string mode = argv[++i];
+            size_t colon = mode.find(':');
+            string value = colon == string::npos ? "" : mode.substr(colon + 1);
+            mode = mode.substr(0, colon);
+            if (mode == "np") {
+                options.preemption = NON_PREEMPTIVE;
+            } else if (mode == "threshold") {
+                options.preemption = PREEMPTION_THRESHOLD;
+                options.threshold_levels = max(atoi(value.c_str()), 0);
+            } else if (mode == "deferred") {
+                options.preemption = DEFERRED_PREEMPTION;
+                options.deferral = max(atof(value.c_str()), 0.0);
+            } else {
+                options.preemption = FULLY_PREEMPTIVE;
+            }
+        } else if (arg == "--switch-cost" && i + 1 < argc) {
+            options.switch_cost = max(atof(argv[++i]), 0.0);
+        } else if (arg == "--overrun-at" && i + 1 < argc) {
+            options.overrun_at = max(atof(argv[++i]), 0.0);
+        } else if (arg == "--dvfs" && i + 1 < argc) {
+            string policy = argv[++i];
+            if (policy == "static") options.dvfs = DVFS_STATIC;
+            else if (policy == "cc") options.dvfs = DVFS_CYCLE_CONSERVING;
+            else options.dvfs = DVFS_NONE;
+        } else if (arg == "--speeds" && i + 1 < argc) {
+            options.speeds.clear();
+            stringstream list(argv[++i]);
+            string speed;
+            while (getline(list, speed, ',')) {
+                double s = atof(speed.c_str());
+                if (s > 0 && s <= 1) options.speeds.push_back(s);
+            }
+            sort(options.speeds.begin(), options.speeds.end());
+            if (options.speeds.empty() || options.speeds.back() != 1) options.speeds.push_back(1);
+        } else if (arg == "--static-power" && i + 1 < argc) {
+            options.static_power = max(atof(argv[++i]), 0.0);
+        } else if (arg == "--llf-quantum" && i + 1 < argc) {
+            options.llf_quantum = atof(argv[++i]);
+        } else {
+            filenames.push_back(arg);
         }
+    }
 
-        print_tasks(&state);
-        print_server_config(&state);
+    if (filenames.empty()) {
+        cerr << "Usage: " << argv[0] << " [-j threads] [--horizon T] [--resolution N] [--analysis] [--llf-quantum Q] [--set N] [--cpus M [--partition ff|bf|wf]] [--stats FILE [--stats-format csv|json]] [--checkpoint PREFIX --checkpoint-at T] [--resume PREFIX] [--sensitivity [--precision P] [--aperiodic-bound T]] [--trace-out PREFIX] [--report FILE [--report-format csv|jsonl]] [--summary-only] [--preemption full|np|threshold:K|deferred:Q] [--switch-cost C] [--overrun-at T] [--dvfs static|cc [--speeds a,b,...] [--static-power P]] <input_file_1> [input_file_2] ..." << endl;
+        return 1;
+    }
 
-        vector<shared_ptr<Task>> tasks;
-        loadTasksFromParser(&state, tasks);
+    unique_ptr<ResponseWriter> stats;
+    if (!options.stats_file.empty()) {
+        stats.reset(new ResponseWriter(options.stats_file, options.stats_json));
+        if (!stats->good()) {
+            cerr << "Error: Cannot write '" << options.stats_file << "'" << endl;
+            return 1;
+        }
+    }
 
-        if (state.server.type == SERVER_NONE) {
-            // No server defined, run periodic schedulers
-            runPeriodicSimulation("RM", tasks, 50);
-            runPeriodicSimulation("DM", tasks, 50);
-            runPeriodicSimulation("EDF", tasks, 50);
-            runPeriodicSimulation("LLF", tasks, 50);
-        } else {
-            // A server is defined, run the appropriate aperiodic simulation
-            runAperiodicSimulation(tasks, 50, state.server);
+    unique_ptr<ReportFile> report;
+    if (!options.report_file.empty()) {
+        report.reset(new ReportFile(options.report_file, options.report_format, options.summary_only));
+        if (!report->good()) {
+            cerr << "Error: Cannot write '" << options.report_file << "'" << endl;
+            return 1;
         }
     }
 
+    if (options.cpus > 1 && (!options.checkpoint.empty() || !options.resume.empty())) {
+        cerr << "Warning: snapshots are only taken of uniprocessor runs" << endl;
+    }
+    if ((options.preemption != FULLY_PREEMPTIVE || options.switch_cost > 0) &&
+        ((options.cpus > 1 && !options.partitioned) || options.sensitivity)) {
+        cerr << "Warning: preemption modes and switch costs only apply to uniprocessor and partitioned simulations"
+             << endl;
+    }
+
+    if ((options.overrun_at >= 0 || options.dvfs != DVFS_NONE) && (options.cpus > 1 || options.sensitivity)) {
+        cerr << "Warning: criticality overruns and speed scaling only apply to uniprocessor periodic simulations"
+             << endl;
+    }
+
+    cout << "Starting RTS Simulator..." << endl;
+
+    if (options.threads > 1) {
+        runFilesParallel(filenames, options, stats.get(), report.get());
+        printCounterTotals();
+        cout << "\n\n=== ALL TESTS COMPLETE ===" << endl;
+        return 0;
+    }
+
+    for (const string& filename : filenames) {
+        // The first banner goes out before parsing, ahead of any parser warnings
+        printSetHeader(filename, firstSet(options));
+        SerialRun run;
+        run.filename = filename;
+        run.options = &options;
+        run.stats = stats.get();
+        run.report = report.get();
+        string error = loadError(filename, options, loadSets(filename, options, SerialRun::runSet, &run));
+        if (!error.empty()) cerr << error << endl;
+    }
+
+    printCounterTotals();
     cout << "\n\n=== ALL TESTS COMPLETE ===" << endl;
     return 0;
 }
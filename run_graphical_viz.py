@@ -2,14 +2,17 @@ import sys
 import subprocess
 import re
 import os
+import tempfile
 import matplotlib.pyplot as plt
 import matplotlib.patches as mpatches
 from matplotlib.patches import FancyBboxPatch, Rectangle
 import numpy as np
+from rts_trace import schedules_from_output
 
-def run_cpp_simulation(input_file):
+def run_cpp_simulation(input_file, trace_prefix=None):
     """
-    Compiles and runs the C++ simulation.
+    Compiles and runs the C++ simulation. With trace_prefix set, the
+    simulator also writes a binary trace of every run (see rts_trace.py).
     """
     executable_name = "run_ali"
     if sys.platform == "win32":
@@ -20,7 +23,7 @@ def run_cpp_simulation(input_file):
     try:
         print(f"[INFO] Running C++ simulation: {executable_path} {input_file}")
         process = subprocess.run(
-            [executable_path, input_file],
+            [executable_path, input_file] + (["--trace-out", trace_prefix] if trace_prefix else []),
             capture_output=True,
             text=True,
             check=True
@@ -299,15 +302,17 @@ def main():
     print(f"{'='*80}\n")
     print(f"Input File: {input_file}\n")
 
-    # Run C++ simulation
-    cpp_output = run_cpp_simulation(input_file)
+    # Run C++ simulation; the schedules come from its binary traces, which
+    # are mapped instead of parsed, and the summaries from its text output
+    with tempfile.TemporaryDirectory() as trace_dir:
+        cpp_output = run_cpp_simulation(input_file, os.path.join(trace_dir, "trace"))
 
-    if not cpp_output:
-        print(f"[ERROR] Failed to get output from C++ program.")
-        sys.exit(1)
+        if not cpp_output:
+            print(f"[ERROR] Failed to get output from C++ program.")
+            sys.exit(1)
 
-    # Parse output
-    schedules, summaries, job_info = parse_cpp_output(cpp_output)
+        schedules, summaries, job_info = parse_cpp_output(cpp_output)
+        schedules.update(schedules_from_output(cpp_output))
 
     if not schedules:
         print(f"[INFO] No schedules were found in the C++ program output.")
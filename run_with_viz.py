@@ -2,6 +2,7 @@ import sys
 import subprocess
 import re
 import os
+import tempfile
 
 # Fix Windows console encoding for Unicode support
 if sys.platform == "win32":
@@ -27,6 +28,12 @@ except ImportError:
     class Style:
         BRIGHT = DIM = NORMAL = RESET_ALL = ""
 
+try:
+    from rts_trace import schedules_from_output  # needs numpy
+    TRACES_AVAILABLE = True
+except ImportError:
+    TRACES_AVAILABLE = False
+
 def print_header(text, char="=", color=Fore.CYAN):
     """Print a styled header"""
     width = 80
@@ -44,11 +51,13 @@ def print_box(title, content, color=Fore.YELLOW):
         print(f"{color}│{Style.RESET_ALL} {line.ljust(width-4)} {color}│{Style.RESET_ALL}")
     print(f"{color}└{'─' * (width-2)}┘{Style.RESET_ALL}")
 
-def run_cpp_simulation(input_file):
+def run_cpp_simulation(input_file, trace_prefix=None):
     """
     Compiles and runs the C++ simulation.
     First, it tries to compile using 'make'.
     Then, it runs the executable with the provided input file and captures the output.
+    With trace_prefix set, the simulator also writes a binary trace of every
+    run (see rts_trace.py).
     """
     executable_name = "run_ali"
     if sys.platform == "win32":
@@ -76,7 +85,7 @@ def run_cpp_simulation(input_file):
     try:
         print(f"{Fore.CYAN}[INFO]{Style.RESET_ALL} Running C++ simulation: {Style.BRIGHT}{executable_path}{Style.RESET_ALL} {input_file}")
         process = subprocess.run(
-            [executable_path, input_file],
+            [executable_path, input_file] + (["--trace-out", trace_prefix] if trace_prefix else []),
             capture_output=True,
             text=True,
             check=True
@@ -309,14 +318,18 @@ def main():
     print(f"{Style.BRIGHT}Input File:{Style.RESET_ALL} {Fore.CYAN}{input_file}{Style.RESET_ALL}\n")
 
     # 1. Run the C++ program and get its output
-    cpp_output = run_cpp_simulation(input_file)
-
-    if not cpp_output:
-        print(f"{Fore.RED}[ERROR]{Style.RESET_ALL} Failed to get output from C++ program.")
-        sys.exit(1)
-
-    # 2. Parse the output into separate schedules
-    schedules, summaries = parse_cpp_output(cpp_output)
+    with tempfile.TemporaryDirectory() as trace_dir:
+        cpp_output = run_cpp_simulation(input_file, os.path.join(trace_dir, "trace") if TRACES_AVAILABLE else None)
+
+        if not cpp_output:
+            print(f"{Fore.RED}[ERROR]{Style.RESET_ALL} Failed to get output from C++ program.")
+            sys.exit(1)
+
+        # 2. Parse the output into separate schedules; with numpy the
+        # schedules are mapped from the binary traces instead
+        schedules, summaries = parse_cpp_output(cpp_output)
+        if TRACES_AVAILABLE:
+            schedules.update(schedules_from_output(cpp_output))
 
     if not schedules:
         print(f"{Fore.YELLOW}[INFO]{Style.RESET_ALL} No schedules were found in the C++ program output.")
@@ -0,0 +1,101 @@
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+
+// Fixed-size thread pool with one work deque per thread. A worker takes
+// tasks from the back of its own deque and, once that runs dry, steals from
+// the front of the others, so one file with a long horizon does not leave
+// the rest of the cores idle behind it.
+class WorkStealingPool {
+private:
+    struct Worker {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    size_t next_worker = 0;
+
+    std::mutex state_lock;
+    std::condition_variable wakeup;
+    long queued = 0;      // submitted but not yet taken by a worker
+    bool stopping = false;
+
+    bool takeFrom(size_t w, bool own, std::function<void()>& task) {
+        std::lock_guard<std::mutex> guard(workers[w]->lock);
+        std::deque<std::function<void()>>& q = workers[w]->tasks;
+        if (q.empty()) return false;
+        if (own) {
+            task = std::move(q.back());
+            q.pop_back();
+        } else {
+            task = std::move(q.front());
+            q.pop_front();
+        }
+        return true;
+    }
+
+    bool take(size_t self, std::function<void()>& task) {
+        if (takeFrom(self, true, task)) return true;
+        for (size_t k = 1; k < workers.size(); k++) {
+            if (takeFrom((self + k) % workers.size(), false, task)) return true;
+        }
+        return false;
+    }
+
+    void work(size_t self) {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> guard(state_lock);
+                wakeup.wait(guard, [this] { return queued > 0 || stopping; });
+                if (queued == 0) return; // stopping and drained
+                queued--;
+            }
+            // A task is reserved for us; it is in some deque, keep looking until we get it
+            std::function<void()> task;
+            while (!take(self, task)) std::this_thread::yield();
+            task();
+        }
+    }
+
+public:
+    explicit WorkStealingPool(int n) {
+        if (n < 1) n = 1;
+        for (int i = 0; i < n; i++) workers.emplace_back(new Worker());
+        for (int i = 0; i < n; i++) threads.emplace_back(&WorkStealingPool::work, this, i);
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Runs every submitted task before joining
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> guard(state_lock);
+            stopping = true;
+        }
+        wakeup.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    // Tasks are dealt round-robin; must be called from a single thread
+    void submit(std::function<void()> task) {
+        Worker& w = *workers[next_worker];
+        next_worker = (next_worker + 1) % workers.size();
+        {
+            std::lock_guard<std::mutex> guard(w.lock);
+            w.tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> guard(state_lock);
+            queued++;
+        }
+        wakeup.notify_one();
+    }
+
+    int size() { return workers.size(); }
+};
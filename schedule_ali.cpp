@@ -1,6 +1,13 @@
-#include "task_ali.cpp"
+#include "readyqueue_ali.cpp"
+#include "snapshot_ali.cpp"
+#include "traceout_ali.cpp"
+#include "instrument_ali.cpp"
 #include <string>
 #include <cmath>
+#include <algorithm>
+#include <map>
+#include <deque>
+#include <sstream>
 
 extern "C" {
 #include "rts_parser.h"
@@ -8,275 +15,674 @@ extern "C" {
 
 using namespace std;
 
+// Snapshot of the job fields the reports need. The simulator recycles jobs
+// once they leave the system, so the scheduler's logs keep these, not Job*.
+struct JobRecord {
+    long seq;            // release order, -1 for an idle slot
+    int task_id;
+    TaskTypes type;
+    Tick abs_deadline;
+};
+
+JobRecord recordOf(Job* job) {
+    if (!job) return {-1, 0, Periodic, 0};
+    return {job->hook.seq, job->getTask()->getId(), job->getType(), job->getAbsDeadline()};
+}
+
+void saveRecord(StateWriter& out, const JobRecord& job) {
+    out.put<int64_t>(job.seq);
+    out.put<int32_t>(job.task_id);
+    out.put<int32_t>(job.type);
+    out.put<Tick>(job.abs_deadline);
+}
+
+JobRecord loadRecord(StateReader& in) {
+    JobRecord job;
+    job.seq = in.get<int64_t>();
+    job.task_id = in.get<int32_t>();
+    job.type = (TaskTypes)in.get<int32_t>();
+    job.abs_deadline = in.get<Tick>();
+    return job;
+}
+
+// One run of the trace: `job` (or idle) held the processor over [start, end).
+// A record is only started on a context switch, so the trace grows with the
+// number of switches, not with the horizon.
+struct TraceRecord {
+    Tick start;
+    Tick end;
+    JobRecord job;
+};
+
+// Read-only view of a contiguous range owned by someone else
+template <class T>
+class Span {
+private:
+    const T* first;
+    size_t count;
+
+public:
+    Span(const vector<T>& v) : first(v.data()), count(v.size()) {}
+
+    const T* begin() const { return first; }
+    const T* end() const { return first + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[](size_t i) const { return first[i]; }
+};
+
+// How far the engine lets a policy preempt the running job (see
+// simulateAs). Only RM, DM, EDF, EDF-VD and AMC take a mode other than the
+// default; the context-switch cost applies to every uniprocessor run.
+enum PreemptionMode {
+    FULLY_PREEMPTIVE,     // the policy's choice always runs
+    NON_PREEMPTIVE,       // a started job runs until it completes
+    PREEMPTION_THRESHOLD, // only jobs above the running job's threshold preempt it
+    DEFERRED_PREEMPTION,  // a preemption waits until the running job had `deferral` more ticks
+};
+
+struct PreemptionConfig {
+    PreemptionMode mode = FULLY_PREEMPTIVE;
+    // Preemption threshold: a task's threshold is its preemption level
+    // raised by this many levels (levels rank the tasks by period for RM,
+    // by relative deadline for DM and EDF; 0 is the top). A job preempts
+    // the running one only if its level is above the running job's
+    // threshold.
+    int threshold_levels = 0;
+    Tick deferral = 0;    // deferred preemption: the non-preemptive region, in ticks
+    Tick switch_cost = 0; // ticks a context switch takes before the dispatched job runs
+
+    bool limited() const { return mode != FULLY_PREEMPTIVE; }
+};
+
+// Short description of a mode, e.g. for the scheduler name
+string preemptionName(const PreemptionConfig& config, Tick resolution = 1) {
+    switch (config.mode) {
+        case NON_PREEMPTIVE: return "non-preemptive";
+        case PREEMPTION_THRESHOLD: return "preemption threshold +" + to_string(config.threshold_levels);
+        case DEFERRED_PREEMPTION: {
+            ostringstream s;
+            s.precision(15);
+            s << "deferred preemption " << (double)config.deferral / resolution;
+            return s.str();
+        }
+        default: return "fully preemptive";
+    }
+}
+
+// Processor speed scaling (see simulateAs). Speeds are fractions of the
+// full frequency: at speed s a job needs its execution time / s, rounded up
+// to ticks.
+enum DvfsPolicy {
+    DVFS_NONE,             // always at full speed
+    DVFS_STATIC,           // one speed for the whole run (PlatformConfig::speed)
+    DVFS_CYCLE_CONSERVING, // cycle-conserving EDF: the lowest speed covering the
+                           // utilization still claimed, a completed job claiming
+                           // only what it ran until its task's next release
+};
+
+// Mixed-criticality behaviour and speed scaling of a uniprocessor run
+struct PlatformConfig {
+    // HI-criticality jobs released at or after this tick run for their HI
+    // execution time; every other job runs for its LO one
+    Tick overrun_at = NEVER;
+    DvfsPolicy dvfs = DVFS_NONE;
+    vector<double> speeds{1.0}; // available speeds, ascending, the last one 1
+    double speed = 1;           // DVFS_STATIC
+    // Power model: the processor draws static_power at all times and
+    // speed^3 more while it runs a job (1 at full speed)
+    double static_power = 0.1;
+
+    bool scaling() const { return dvfs != DVFS_NONE; }
+    double power(double s) const { return static_power + s * s * s; }
+    // Lowest available speed of at least `s`, the highest if none is
+    double speedFor(double s) const {
+        for (double level : speeds) {
+            if (level >= s - 1e-9) return level;
+        }
+        return speeds.back();
+    }
+};
+
 class Scheduler {
 private:
     string name;
-    double curr_time;
-    // i found a way to push multiple types using tuples
-    vector<tuple<double, Job*>> logs;
-    vector<Job*> finished_jobs;
-    vector<Job*> missed_deadlines;
+    PreemptionConfig preemption;
+    PlatformConfig platform;
+    Tick curr_time;
+    vector<TraceRecord> logs;
+    long finished_count = 0;
+    vector<JobRecord> missed_deadlines;
+    TraceExport* trace_out = nullptr; // streams the trace as it becomes final
+    int trace_core = -1;
+
+    void exportSlice(const TraceRecord& record) {
+        const JobRecord& job = record.job;
+        trace_out->slice(record.start, record.end, job.seq, job.task_id, job.type, job.abs_deadline, trace_core);
+    }
+    void exportMiss(const JobRecord& job) { trace_out->miss(job.seq, job.task_id, job.type, job.abs_deadline); }
 
 public:
 
-    Scheduler(string n) : name(n), curr_time(0) {}
+    Scheduler(string n) : name(n), curr_time(0) { logs.reserve(256); }
+    virtual ~Scheduler() {}
 
-    void clockTick(double t) {
+    void clockTick(Tick t) {
         curr_time = curr_time + t;
+        if (!logs.empty()) logs.back().end = curr_time;
     }
-    double getCurrentTime() {
+    Tick getCurrentTime() {
         return curr_time;
     }
+    // Records that `job` (NULL = idle) runs from now on
     void addLog(Job* job) {
-        logs.push_back({curr_time, job});
+        long seq = job ? job->hook.seq : -1;
+        if (!logs.empty() && logs.back().job.seq == seq) return;
+        // The record it ends is final
+        if (trace_out && !logs.empty()) exportSlice(logs.back());
+        logs.push_back({curr_time, curr_time, recordOf(job)});
     }
-    void addFinishedJob(Job* job) {
-        finished_jobs.push_back(job);
+    void addFinishedJob(Job* /*job*/) {
+        finished_count++;
     }
     void addMissedDeadline(Job* job) {
-        missed_deadlines.push_back(job);
+        missed_deadlines.push_back(recordOf(job));
+        if (trace_out) exportMiss(missed_deadlines.back());
+    }
+
+    // Streams every trace record and deadline miss to `out` from now on,
+    // the slices marked as run on `core`. The in-memory logs are kept.
+    void exportTrace(TraceExport* out, int core = -1) {
+        trace_out = out;
+        trace_core = core;
+    }
+    // Exports the record still open at the end of the run and stops exporting
+    void finishTrace() {
+        if (trace_out && !logs.empty()) exportSlice(logs.back());
+        trace_out = nullptr;
     }
     //delete????????
     // Getters for printing results
-    vector<tuple<double, Job*>> getLogs() { return logs; }
-    vector<Job*> getFinishedJobs() { return finished_jobs; }
-    vector<Job*> getMissedDeadlines() { return missed_deadlines; }
+    Span<TraceRecord> getLogs() { return logs; }
+    long getFinishedCount() { return finished_count; }
+    Span<JobRecord> getMissedDeadlines() { return missed_deadlines; }
     string getName() { return name; }
 
+    // A limited-preemption mode is named after the policy, e.g. "Rate
+    // Monotonic (non-preemptive)". Set before the run.
+    void setPreemption(const PreemptionConfig& config, Tick resolution = 1) {
+        if (config.limited()) name += " (" + preemptionName(config, resolution) + ")";
+        preemption = config;
+    }
+    const PreemptionConfig& getPreemption() { return preemption; }
+    // Whether the policy takes a mode other than FULLY_PREEMPTIVE
+    virtual bool supportsLimitedPreemption() { return false; }
+    // The key whose rank among the tasks is a task's preemption level,
+    // smallest first
+    virtual Tick preemptionKey(const Task& task) { return task.getD(); }
+
+    // Set before the run
+    void setPlatform(const PlatformConfig& config) { platform = config; }
+    const PlatformConfig& getPlatform() { return platform; }
+    // Mixed-criticality policies: once a HI job runs past its LO execution
+    // time the engine switches the system to HI mode, drops every LO job and
+    // calls criticalityChange(true); it goes back to LO at the next idle
+    // instant. Other policies never see a mode switch.
+    virtual bool mixedCriticality() { return false; }
+    virtual void criticalityChange(bool /*high*/) {}
+
+    // Snapshots: the clock and everything recorded so far
+    void saveTrace(StateWriter& out) {
+        out.put<Tick>(curr_time);
+        out.put<uint64_t>(logs.size());
+        for (const auto& record : logs) {
+            out.put<Tick>(record.start);
+            out.put<Tick>(record.end);
+            saveRecord(out, record.job);
+        }
+        out.put<int64_t>(finished_count);
+        out.put<uint64_t>(missed_deadlines.size());
+        for (const auto& job : missed_deadlines) saveRecord(out, job);
+    }
+    void loadTrace(StateReader& in) {
+        curr_time = in.get<Tick>();
+        logs.clear();
+        for (uint64_t n = in.get<uint64_t>(); n > 0 && in.ok(); n--) {
+            Tick start = in.get<Tick>();
+            Tick end = in.get<Tick>();
+            logs.push_back({start, end, loadRecord(in)});
+        }
+        finished_count = in.get<int64_t>();
+        missed_deadlines.clear();
+        for (uint64_t n = in.get<uint64_t>(); n > 0 && in.ok(); n--) missed_deadlines.push_back(loadRecord(in));
+        // A resumed run exports what the earlier pieces recorded first, in
+        // the order a single run streams it: a miss is reported before the
+        // record running at its deadline is closed
+        if (trace_out && in.ok()) {
+            size_t m = 0;
+            for (size_t i = 0; i + 1 < logs.size(); i++) {
+                for (; m < missed_deadlines.size() && missed_deadlines[m].abs_deadline <= logs[i].end; m++) {
+                    exportMiss(missed_deadlines[m]);
+                }
+                exportSlice(logs[i]);
+            }
+            for (; m < missed_deadlines.size(); m++) exportMiss(missed_deadlines[m]);
+        }
+    }
+
+    // Ready queue maintenance: the simulator reports every release, completion
+    // and deadline miss, so schedulers keep their ready structure across ticks
+    // instead of rebuilding it for each decision.
+    virtual void prepare(const vector<Task>& /*tasks*/) {}
+    virtual void addReady(Job* job) = 0;
+    virtual void removeReady(Job* job) = 0;
+
     // to be able to access to the child's function from pointer of this one
-    virtual Job* selectTask(vector<Job*> queue) = 0;
+    virtual Job* selectTask() = 0;
+    // Multiprocessor dispatch (see multicore_ali.cpp): appends the jobs that
+    // should run on m processors, best first. Only the policies with a global
+    // variant (RM, DM, EDF) return more than selectTask()'s single job.
+    virtual void selectTasks(int m, vector<Job*>& out) {
+        Job* job = m > 0 ? selectTask() : NULL;
+        if (job) out.push_back(job);
+    }
+    virtual bool supportsGlobal() { return false; }
 
     // Default implementations for non-server schedulers (RM, EDF, LLF)
-    virtual double budgetReplenishment() { return 0; }
-    virtual double budgetConsumption(double exec) { return 0; }
-    virtual void execute_server_version(Job* job, double t) {
+    virtual Tick budgetReplenishment() { return 0; }
+    virtual Tick budgetConsumption(Tick exec) { return 0; }
+    virtual void execute_server_version(Job* job, Tick t) {
         if(job) job->execute(t);
     }
-    virtual double getReplenishmentPeriod() { return 0; }
+    virtual Tick getReplenishmentPeriod() { return 0; }
+
+    // Event-driven engine hooks (see sim_ali.cpp).
+    // decisionHorizon: time until which the job just returned by selectTask
+    // is guaranteed to stay selected if no job is released, completes or
+    // misses its deadline. Static-priority policies never change their mind
+    // on their own, so the default is "forever".
+    virtual Tick decisionHorizon(Job* /*selected*/) { return NEVER; }
+    // nextReplenishment: next instant at which budgetReplenishment() changes
+    // the scheduler state.
+    virtual Tick nextReplenishment() { return NEVER; }
+    // Appends whatever internal state (beyond the ready jobs) influences
+    // future decisions; used to detect that a schedule has become periodic.
+    virtual void stateSignature(vector<Tick>& /*sig*/) {}
+    // Unlike the signature, the exact internal state, in absolute times, for
+    // resuming a snapshot. loadState() runs once every ready job of the
+    // snapshot has been handed back through addReady().
+    virtual void saveState(StateWriter& /*out*/) {}
+    virtual void loadState(StateReader& /*in*/) {}
 };
 
-class RMScheduling : public Scheduler {
+// Maps each distinct value of a task's priority key (period for RM, relative
+// deadline for DM) onto a bucket level, smallest key first
+map<Tick, int> priorityLevels(const vector<Task>& tasks, Tick (Task::*key)() const) {
+    map<Tick, int> levels;
+    for (const auto& task : tasks) levels[(task.*key)()] = 0;
+    int level = 0;
+    for (auto& entry : levels) entry.second = level++;
+    return levels;
+}
+
+class RMScheduling final : public Scheduler {
 private:
+    PriorityBuckets buckets;
+    map<Tick, int> levels; // period -> priority level
 public:
     RMScheduling() : Scheduler("Rate Monotonic") {}
     // dynamic?????
-    Job* selectTask(vector<Job*> queue) {
-        if (queue.empty()) return NULL;
-
-        //select the highest priority
-        Job* highest = queue.front();
-        for(int i = 1; i < queue.size(); i++) {
-            if(queue[i]->getTask()->getP() < highest->getTask()->getP()) highest = queue[i];
-        }
+    void prepare(const vector<Task>& tasks) {
+        levels = priorityLevels(tasks, &Task::getP);
+        buckets.setLevels(levels.size());
+    }
+    void addReady(Job* job) { buckets.push(job, levels[job->getP()]); }
+    void removeReady(Job* job) { buckets.remove(job); }
 
-        return highest;
-    } 
+    //select the highest priority
+    Job* selectTask() { return buckets.top(); }
+    void selectTasks(int m, vector<Job*>& out) { buckets.topN(m, out); }
+    bool supportsGlobal() { return true; }
+    bool supportsLimitedPreemption() { return true; }
+    Tick preemptionKey(const Task& task) { return task.getP(); }
 };
 
-class DMScheduling : public Scheduler {
+class DMScheduling final : public Scheduler {
     private:
+        PriorityBuckets buckets;
+        map<Tick, int> levels; // relative deadline -> priority level
     public:
         DMScheduling() : Scheduler("Deadline Monotonic") {}
         // dynamic?????
-        Job* selectTask(vector<Job*> queue) {
-            if (queue.empty()) return NULL;
-    
-            //select the highest priority
-            Job* highest = queue.front();
-            for(int i = 1; i < queue.size(); i++) {
-                if(queue[i]->getTask()->getD() < highest->getTask()->getD()) highest = queue[i];
-            }
-    
-            return highest;
-        } 
+        void prepare(const vector<Task>& tasks) {
+            levels = priorityLevels(tasks, &Task::getD);
+            buckets.setLevels(levels.size());
+        }
+        void addReady(Job* job) { buckets.push(job, levels[job->getD()]); }
+        void removeReady(Job* job) { buckets.remove(job); }
+
+        //select the highest priority
+        Job* selectTask() { return buckets.top(); }
+        void selectTasks(int m, vector<Job*>& out) { buckets.topN(m, out); }
+        bool supportsGlobal() { return true; }
+        bool supportsLimitedPreemption() { return true; }
     };
 
-class EDFScheduling : public Scheduler {
+struct EarlierDeadline {
+    bool operator()(Job* a, Job* b) { return a->getAbsDeadline() < b->getAbsDeadline(); }
+};
+
+class EDFScheduling final : public Scheduler {
+private:
+    JobHeap<EarlierDeadline> heap;
 
 public:
     EDFScheduling() : Scheduler("Earliest Deadline First") {}
- 
-    Job* selectTask(vector<Job*> queue) {
-        if (queue.empty()) return NULL;
 
-        //select the highest priority
-        Job* highest = queue.front();
-        for(int i = 1; i < queue.size(); i++) {
-            if(queue[i]->getAbsDeadline() < highest->getAbsDeadline()) highest = queue[i];
-        }
+    void addReady(Job* job) { heap.push(job); }
+    void removeReady(Job* job) { heap.remove(job); }
 
-        return highest;
-    } 
+    //select the highest priority
+    Job* selectTask() { return heap.top(); }
+    void selectTasks(int m, vector<Job*>& out) { heap.topN(m, out); }
+    bool supportsGlobal() { return true; }
+    bool supportsLimitedPreemption() { return true; }
 };
 
-class LLFScheduling : public Scheduler {
+// The mixed-criticality policies, on the EDF and RM selectors.
+//  - EDF-VD (Baruah et al.): in LO mode a HI job is scheduled by a virtual
+//    deadline, x times its relative deadline after its release, which keeps
+//    room for its HI execution time should it overrun; in HI mode by its
+//    real one. x = U_HI(LO) / (1 - U_LO(LO)), or 1 (plain EDF) when the set
+//    fits at every task's largest execution time.
+//  - AMC (adaptive mixed criticality, Baruah, Burns & Davis): rate
+//    monotonic priorities, the LO tasks abandoned in HI mode.
+// Utilizations are densities, C / min(D, P).
+struct EarlierKey {
+    bool operator()(Job* a, Job* b) { return a->hook.key < b->hook.key; }
+};
+
+class EDFVDScheduling final : public Scheduler {
+private:
+    JobHeap<EarlierKey> heap;
+    double factor = 1;
+    bool passes = true;
+    bool high = false;
+
+    void setKey(Job* job) {
+        Tick d = job->getD();
+        if (!high && job->getTask()->getCriticality() == HiCriticality) d = max<Tick>((Tick)floor(factor * d), 1);
+        job->hook.key = job->getJobReleaseTime() + d;
+    }
 
 public:
-    LLFScheduling() : Scheduler("Least Laxity First") {}
- 
-    Job* selectTask(vector<Job*> queue) {
-        if (queue.empty()) return NULL;
+    EDFVDScheduling() : Scheduler("EDF with Virtual Deadlines") {}
 
-        //select the highest priority (lowest laxity)
-        // Laxity = deadline - currentTime - remainingExecution
-        Job* highest = queue.front();
-        double curr = getCurrentTime();
-        for(int i = 1; i < queue.size(); i++) {
-            double laxity_i = queue[i]->getAbsDeadline() - curr - queue[i]->getRem();
-            double laxity_highest = highest->getAbsDeadline() - curr - highest->getRem();
-            if(laxity_i < laxity_highest) highest = queue[i];
+    void prepare(const vector<Task>& tasks) {
+        double lo_lo = 0, hi_lo = 0, hi_hi = 0;
+        for (const auto& task : tasks) {
+            if (task.getType() == Aperiodic || task.getP() <= 0) continue;
+            double window = min(task.getD(), task.getP());
+            if (task.getCriticality() == HiCriticality) {
+                hi_lo += task.getE() / window;
+                hi_hi += task.getEHi() / window;
+            } else {
+                lo_lo += task.getE() / window;
+            }
         }
+        factor = 1;
+        passes = lo_lo + hi_hi <= 1;
+        if (!passes && lo_lo < 1 && hi_lo / (1 - lo_lo) <= 1) {
+            factor = hi_lo / (1 - lo_lo);
+            passes = factor * lo_lo + hi_hi <= 1;
+        }
+        high = false;
+    }
+    // Virtual deadline factor, and whether the EDF-VD test passes with it
+    double virtualDeadlineFactor() { return factor; }
+    bool passesTest() { return passes; }
 
-        return highest;
-    } 
+    void addReady(Job* job) {
+        setKey(job);
+        heap.push(job);
+    }
+    void removeReady(Job* job) { heap.remove(job); }
+
+    Job* selectTask() { return heap.top(); }
+    bool supportsLimitedPreemption() { return true; }
+    bool mixedCriticality() { return true; }
+
+    void criticalityChange(bool h) {
+        high = h;
+        for (Job* job : heap.jobs()) setKey(job);
+        heap.rebuild();
+    }
+
+    void stateSignature(vector<Tick>& sig) { sig.push_back(high); }
+    void saveState(StateWriter& out) { out.put<uint8_t>(high); }
+    void loadState(StateReader& in) { criticalityChange(in.get<uint8_t>()); }
 };
 
-class BackgroundScheduling : public Scheduler {
+class AMCScheduling final : public Scheduler {
 private:
-    ParsedSchedulingType sched_type;
+    PriorityBuckets buckets;
+    map<Tick, int> levels; // period -> priority level
+public:
+    AMCScheduling() : Scheduler("Adaptive Mixed Criticality") {}
+    void prepare(const vector<Task>& tasks) {
+        levels = priorityLevels(tasks, &Task::getP);
+        buckets.setLevels(levels.size());
+    }
+    void addReady(Job* job) { buckets.push(job, levels[job->getP()]); }
+    void removeReady(Job* job) { buckets.remove(job); }
 
-    // Helper: compare two jobs based on scheduling type (returns true if j1 has higher priority)
-    bool hasHigherPriority(Job* j1, Job* j2) {
-        if (sched_type == SCHED_RM) {
-            return j1->getTask()->getP() < j2->getTask()->getP();
-        } else { // SCHED_EDF
-            return j1->getAbsDeadline() < j2->getAbsDeadline();
-        }
+    Job* selectTask() { return buckets.top(); }
+    bool supportsLimitedPreemption() { return true; }
+    Tick preemptionKey(const Task& task) { return task.getP(); }
+    bool mixedCriticality() { return true; }
+};
+
+// Laxity is deadline - now - remaining. `now` is the same for every job, so
+// jobs are kept ordered on deadline - remaining: the laxity plus a global
+// time offset. A waiting job's key is constant and the running job's grows
+// by the time it executes, so only the running job ever moves in the heap.
+struct LowerSlack {
+    bool operator()(Job* a, Job* b) {
+        return a->getAbsDeadline() - a->getRem() < b->getAbsDeadline() - b->getRem();
     }
+};
+
+class LLFScheduling final : public Scheduler {
+private:
+    JobHeap<LowerSlack> heap;
+    // A dispatched job keeps the processor for at least `quantum` time units
+    // (unless it finishes or misses), which bounds the back-and-forth
+    // switching of jobs whose laxities meet. 1 is plain LLF.
+    Tick quantum;
+    Job* running = NULL;
+    Tick quantum_end = 0;
 
 public:
-    BackgroundScheduling(ParsedSchedulingType st = SCHED_RM)
-        : Scheduler("Background Scheduling"), sched_type(st) {}
+    LLFScheduling(Tick q = 1) : Scheduler("Least Laxity First"), quantum(q) {}
 
-    Job* selectTask(vector<Job*> q) {
-        Job* highest = NULL;
-        vector<Job*> periodic_queue;
-        vector<Job*> aperiodic_queue;
+    void addReady(Job* job) { heap.push(job); }
+    void removeReady(Job* job) {
+        heap.remove(job);
+        if (job == running) running = NULL;
+    }
 
-        // Separate periodic and aperiodic tasks
-        for(int k = 0; k < q.size(); k++) {
-            if(q[k]->getTask()->getType() == Periodic || q[k]->getTask()->getType() == Dynamic) {
-                periodic_queue.push_back(q[k]);
-            }
-            else {
-                aperiodic_queue.push_back(q[k]);
-            }
+    //select the highest priority (lowest laxity)
+    Job* selectTask() {
+        if (running && getCurrentTime() < quantum_end) return running;
+        Job* highest = heap.top();
+        if (highest != running) {
+            running = highest;
+            quantum_end = getCurrentTime() + quantum;
         }
+        return highest;
+    }
 
-        // Background scheduling: periodic tasks have absolute priority
-        if (!periodic_queue.empty()) {
-            // Select highest priority periodic task using base scheduler (RM or EDF)
-            highest = periodic_queue.front();
-            for(int i = 1; i < periodic_queue.size(); i++) {
-                if(hasHigherPriority(periodic_queue[i], highest)) {
-                    highest = periodic_queue[i];
-                }
-            }
-        }
-        else if (!aperiodic_queue.empty()) {
-            // Only run aperiodic tasks when NO periodic tasks are waiting
-            // Use FCFS: select the first aperiodic task in the queue
-            highest = aperiodic_queue.front();
+    void execute_server_version(Job* job, Tick t) {
+        job->execute(t);
+        heap.update(job);
+    }
+
+    // The running job's laxity stays constant while every waiting job loses
+    // one unit per tick, so the next switch is the first tick at which the
+    // runner-up becomes strictly smaller (or equal, if it was released
+    // first). No other waiting job can get there sooner.
+    Tick decisionHorizon(Job* selected) {
+        Tick curr = getCurrentTime();
+        if (curr < quantum_end && selected != heap.top()) return quantum_end;
+        Job* next = selected == heap.top() ? heap.second() : heap.top();
+        if (next == NULL) return NEVER;
+        Tick gap = (next->getAbsDeadline() - next->getRem()) - (selected->getAbsDeadline() - selected->getRem());
+        Tick ticks = next->hook.seq < selected->hook.seq ? gap : gap + 1;
+        return std::max(curr + std::max<Tick>(ticks, 1), quantum_end);
+    }
+
+    void stateSignature(vector<Tick>& sig) {
+        Tick curr = getCurrentTime();
+        if (running && curr < quantum_end) {
+            sig.push_back(running->getTask()->getId());
+            sig.push_back(curr - running->getJobReleaseTime());
+            sig.push_back(quantum_end - curr);
         }
+    }
 
-        return highest;
+    void saveState(StateWriter& out) {
+        out.putJob(running);
+        out.put<Tick>(quantum_end);
+    }
+    void loadState(StateReader& in) {
+        running = in.getJob();
+        quantum_end = in.get<Tick>();
+    }
+};
+
+// Base orderings of the periodic jobs under a server, as compile-time
+// policies: the server classes are templates on one of them, so no priority
+// comparison has to branch on the configured scheduling type.
+struct ShorterPeriod {
+    bool operator()(Job* a, Job* b) { return a->getP() < b->getP(); }
+};
+
+struct RMOrder {
+    typedef ShorterPeriod Before;
+    static const bool edf = false;
+    // Whether a waiting periodic job outranks a server with the given period
+    // and current deadline
+    static bool preemptsServer(Job* periodic, Tick server_period, Tick /*server_deadline*/) {
+        return periodic->getP() < server_period;
+    }
+};
+
+struct EDFOrder {
+    typedef EarlierDeadline Before;
+    static const bool edf = true;
+    static bool preemptsServer(Job* periodic, Tick /*server_period*/, Tick server_deadline) {
+        return periodic->getAbsDeadline() < server_deadline;
     }
 };
 
-class PollerScheduling : public Scheduler {
+template <class Order>
+class BackgroundScheduling final : public Scheduler {
 private:
-    const double budget;
-    double rem_budget = 0;
-    double rep_period;
-    ParsedSchedulingType sched_type;
+    JobHeap<typename Order::Before> periodic; // jobs ordered by the base scheduler
+    JobFifo aperiodic;                        // jobs served first come first served
+
+    static bool isPeriodic(Job* job) { return job->getType() == Periodic || job->getType() == Dynamic; }
+
+public:
+    BackgroundScheduling() : Scheduler("Background Scheduling") {}
 
-    // Helper: compare two jobs based on scheduling type (returns true if j1 has higher priority)
-    bool hasHigherPriority(Job* j1, Job* j2) {
-        if (sched_type == SCHED_RM) {
-            return j1->getTask()->getP() < j2->getTask()->getP();
-        } else { // SCHED_EDF
-            return j1->getAbsDeadline() < j2->getAbsDeadline();
+    void addReady(Job* job) {
+        if (isPeriodic(job)) periodic.push(job);
+        else aperiodic.push(job);
+    }
+    void removeReady(Job* job) {
+        if (isPeriodic(job)) periodic.remove(job);
+        else aperiodic.remove(job);
+    }
+
+    Job* selectTask() {
+        // Background scheduling: periodic tasks have absolute priority
+        if (!periodic.empty()) {
+            // Select highest priority periodic task using base scheduler (RM or EDF)
+            return periodic.top();
         }
+        // Only run aperiodic tasks when NO periodic tasks are waiting
+        // Use FCFS: select the first aperiodic task in the queue
+        return aperiodic.front();
     }
+};
+
+template <class Order>
+class PollerScheduling final : public Scheduler {
+private:
+    const Tick budget;
+    Tick rem_budget = 0;
+    Tick rep_period;
+
+    JobHeap<typename Order::Before> periodic; // jobs ordered by the base scheduler
+    JobFifo aperiodic;                        // every other job, first come first served
+
+    static bool isPeriodic(Job* job) { return job->getType() == Periodic; }
 
 public:
-    PollerScheduling(double r, double b, ParsedSchedulingType st = SCHED_RM)
-        : Scheduler("Poller Scheduling"), rep_period(r), budget(b), sched_type(st) {}
+    PollerScheduling(Tick r, Tick b) : Scheduler("Poller Scheduling"), budget(b), rep_period(r) {}
  
-    Job* selectTask(vector<Job*> q) {
+    void addReady(Job* job) {
+        if (isPeriodic(job)) periodic.push(job);
+        else aperiodic.push(job);
+    }
+    void removeReady(Job* job) {
+        if (isPeriodic(job)) periodic.remove(job);
+        else aperiodic.remove(job);
+    }
+
+    Job* selectTask() {
         Job* highest = NULL;
-        vector<Job*> queue;
-        vector<Job*> aper_queue;
-        for(int k = 0; k < q.size(); k++) {
-            if(q[k]->getTask()->getType() == Periodic) {
-                queue.push_back(q[k]);
-            }
-            else {
-                aper_queue.push_back(q[k]);
-            }
-        }
+        Job* highest_periodic = periodic.top();
 
         if (rem_budget > 0) {
             // if there is no waiting periodic job then select the aperiodic job that has the most privilege
-            if(!aper_queue.empty()) {
+            if(!aperiodic.empty()) {
                 // FCFS: serve aperiodic tasks in arrival order
-                highest = aper_queue.front();
+                highest = aperiodic.front();
 
                 // Compare periodic tasks against server using configured scheduling
-                if(queue.size() != 0) {
-                    // Find highest priority periodic
-                    Job* highest_periodic = queue.front();
-                    for(int i = 1; i < queue.size(); i++) {
-                        if(hasHigherPriority(queue[i], highest_periodic)) {
-                            highest_periodic = queue[i];
-                        }
-                    }
+                if(highest_periodic) {
                     // Check if periodic has priority over server (compare with replenishment period)
-                    bool periodic_preempts = false;
-                    if (sched_type == SCHED_RM) {
-                        periodic_preempts = (highest_periodic->getTask()->getP() < rep_period);
-                    } else { // SCHED_EDF
-                        periodic_preempts = (highest_periodic->getAbsDeadline() < getCurrentTime() + rep_period);
-                    }
-
-                    if(periodic_preempts) {
+                    if(Order::preemptsServer(highest_periodic, rep_period, getCurrentTime() + rep_period)) {
                         highest = highest_periodic;
                         rem_budget = 0;  // Discard budget when periodic preempts
                     }
                 }
             }
-            else if(!queue.empty()) {
+            else if(highest_periodic) {
                 // Only periodic tasks, with budget available
                 rem_budget = 0;  // Polling Server: discard unused budget
-                highest = queue.front();
-                // Select periodic task based on scheduling type
-                for(int i = 1; i < queue.size(); i++) {
-                    if(hasHigherPriority(queue[i], highest))
-                        highest = queue[i];
-                }
+                highest = highest_periodic;
             }
         }
         else {
-        //select the highest priority based on scheduling type
-            if(queue.size() != 0) {
-                highest = queue.front();
-                for(int i = 1; i < queue.size(); i++) {
-                    if(hasHigherPriority(queue[i], highest)) highest = queue[i];
-                }
-            }
+            //select the highest priority based on scheduling type
+            highest = highest_periodic;
         }
         return highest;
     }
 
-    double budgetReplenishment() {
-        if(std::fmod(getCurrentTime(), rep_period) < 0.01) {
+    Tick budgetReplenishment() {
+        if(rep_period > 0 && getCurrentTime() % rep_period == 0) {
             rem_budget = budget;
+            countBudget(&SimCounters::replenishments);
         }
         return rem_budget;
     }
 
-    double budgetConsumption(double exec) {
-        double consumed = 0;
+    Tick budgetConsumption(Tick exec) {
+        Tick consumed = 0;
         if(rem_budget > 0) {
             if(rem_budget > exec) {
                 consumed = exec;
@@ -290,9 +696,11 @@ public:
         return consumed;
     }
 
-    void execute_server_version(Job* job, double t) {
-        if(job->getTask()->getType() == Aperiodic) {
-            double consume = budgetConsumption(t);
+    void execute_server_version(Job* job, Tick t) {
+        if(job->getType() == Aperiodic) {
+            Tick consume = budgetConsumption(t);
+            countBudget(&SimCounters::consumptions, consume > 0);
+            countBudget(&SimCounters::consumed, consume);
             job->execute(consume);
         }
         else {
@@ -300,104 +708,102 @@ public:
         }
     }
 
-    double getReplenishmentPeriod() { return rep_period; }
+    Tick getReplenishmentPeriod() { return rep_period; }
+
+    // A polled aperiodic job only ever gets a single tick before the budget is dropped
+    Tick decisionHorizon(Job* selected) {
+        if(selected->getType() == Aperiodic) return getCurrentTime() + 1;
+        if(selected->getType() == Dynamic && rem_budget > 0 && Order::edf) {
+            return edfPreemptionTime();
+        }
+        return NEVER;
+    }
+
+    void stateSignature(vector<Tick>& sig) { sig.push_back(rem_budget); }
+    void saveState(StateWriter& out) { out.put<Tick>(rem_budget); }
+    void loadState(StateReader& in) { rem_budget = in.get<Tick>(); }
+
+    Tick nextReplenishment() {
+        if (rep_period <= 0) return NEVER;
+        return (getCurrentTime() / rep_period + 1) * rep_period;
+    }
+
+    // Under EDF a waiting periodic job takes over from the server as soon as
+    // its deadline falls inside the current replenishment window. Only used
+    // with EDFOrder, where the periodic heap is ordered on deadlines.
+    Tick edfPreemptionTime() {
+        Job* highest_periodic = periodic.top();
+        if(highest_periodic == NULL) return NEVER;
+        return highest_periodic->getAbsDeadline() - rep_period + 1;
+    }
 };
 
 
-class DeferableScheduling : public Scheduler {
+template <class Order>
+class DeferableScheduling final : public Scheduler {
 private:
-    const double budget;
-    double rem_budget = 0;
-    const double rep_period;
-    ParsedSchedulingType sched_type;
+    const Tick budget;
+    Tick rem_budget = 0;
+    const Tick rep_period;
 
-    // Helper: compare two jobs based on scheduling type (returns true if j1 has higher priority)
-    bool hasHigherPriority(Job* j1, Job* j2) {
-        if (sched_type == SCHED_RM) {
-            return j1->getTask()->getP() < j2->getTask()->getP();
-        } else { // SCHED_EDF
-            return j1->getAbsDeadline() < j2->getAbsDeadline();
-        }
-    }
+    JobHeap<typename Order::Before> periodic; // jobs ordered by the base scheduler
+    JobFifo aperiodic;                        // every other job, first come first served
+
+    static bool isPeriodic(Job* job) { return job->getType() == Periodic; }
 
 public:
-    DeferableScheduling(double r, double b, ParsedSchedulingType st = SCHED_RM)
-        : Scheduler("Deferable Scheduling"), rep_period(r), budget(b), sched_type(st) {}
+    DeferableScheduling(Tick r, Tick b) : Scheduler("Deferable Scheduling"), budget(b), rep_period(r) {}
  
-    Job* selectTask(vector<Job*> q) {
+    void addReady(Job* job) {
+        if (isPeriodic(job)) periodic.push(job);
+        else aperiodic.push(job);
+    }
+    void removeReady(Job* job) {
+        if (isPeriodic(job)) periodic.remove(job);
+        else aperiodic.remove(job);
+    }
+
+    Job* selectTask() {
         Job* highest = NULL;
-        vector<Job*> queue;
-        vector<Job*> aper_queue;
-        for(int k = 0; k < q.size(); k++) {
-            if(q[k]->getTask()->getType() == Periodic) {
-                queue.push_back(q[k]);
-            }
-            else {
-                aper_queue.push_back(q[k]);
-            }
-        }
+        Job* highest_periodic = periodic.top();
 
         if (rem_budget > 0) {
             // if there is no waiting periodic job then select the aperiodic job that has the most privilege
-            if(!aper_queue.empty()) {
+            if(!aperiodic.empty()) {
                 // FCFS: serve aperiodic tasks in arrival order
-                highest = aper_queue.front();
+                highest = aperiodic.front();
 
                 // Compare periodic tasks against server using configured scheduling
-                if(queue.size() != 0) {
-                    // Find highest priority periodic
-                    Job* highest_periodic = queue.front();
-                    for(int i = 1; i < queue.size(); i++) {
-                        if(hasHigherPriority(queue[i], highest_periodic)) {
-                            highest_periodic = queue[i];
-                        }
-                    }
+                if(highest_periodic) {
                     // Check if periodic has priority over server (compare with replenishment period)
-                    bool periodic_preempts = false;
-                    if (sched_type == SCHED_RM) {
-                        periodic_preempts = (highest_periodic->getTask()->getP() < rep_period);
-                    } else { // SCHED_EDF
-                        periodic_preempts = (highest_periodic->getAbsDeadline() < getCurrentTime() + rep_period);
-                    }
-
-                    if(periodic_preempts) {
+                    if(Order::preemptsServer(highest_periodic, rep_period, getCurrentTime() + rep_period)) {
                         highest = highest_periodic;
                     }
                 }
             }
-            else if(!queue.empty()) {
+            else if(highest_periodic) {
                 // Only periodic tasks, with budget available
                 // Deferrable server preserves budget when serving periodic tasks
-                highest = queue.front();
-                // Select periodic task based on scheduling type
-                for(int i = 1; i < queue.size(); i++) {
-                    if(hasHigherPriority(queue[i], highest))
-                        highest = queue[i];
-                }
-                // Don't discard budget - Deferrable preserves it until replenishment
+                highest = highest_periodic;
             }
         }
         else {
-        //select the highest priority based on scheduling type
-            if(queue.size() != 0) {
-                highest = queue.front();
-                for(int i = 1; i < queue.size(); i++) {
-                    if(hasHigherPriority(queue[i], highest)) highest = queue[i];
-                }
-            }
+            //select the highest priority based on scheduling type
+            highest = highest_periodic;
         }
         return highest;
     }
 
-    double budgetReplenishment() {
-        if(std::fmod(getCurrentTime(), rep_period) < 0.01) {
+    Tick budgetReplenishment() {
+        if(rep_period > 0 && getCurrentTime() % rep_period == 0) {
             rem_budget = budget;
+            countBudget(&SimCounters::replenishments);
         }
         return rem_budget;
     }
 
-    double budgetConsumption(double exec) {
-        double consumed = 0;
+    Tick budgetConsumption(Tick exec) {
+        Tick consumed = 0;
         if(rem_budget > 0) {
             if(rem_budget > exec) {
                 consumed = exec;
@@ -411,9 +817,11 @@ public:
         return consumed;
     }
 
-    void execute_server_version(Job* job, double t) {
-        if(job->getTask()->getType() == Aperiodic) {
-            double consume = budgetConsumption(t);
+    void execute_server_version(Job* job, Tick t) {
+        if(job->getType() == Aperiodic) {
+            Tick consume = budgetConsumption(t);
+            countBudget(&SimCounters::consumptions, consume > 0);
+            countBudget(&SimCounters::consumed, consume);
             job->execute(consume);
         }
         else {
@@ -421,6 +829,310 @@ public:
         }
     }
 
-    double getReplenishmentPeriod() { return rep_period; }
+    Tick getReplenishmentPeriod() { return rep_period; }
+
+    Tick decisionHorizon(Job* selected) {
+        if(selected->getType() == Periodic || rem_budget <= 0) return NEVER;
+        Tick horizon = NEVER;
+        if(selected->getType() == Aperiodic) horizon = getCurrentTime() + rem_budget;
+        if(Order::edf) horizon = std::min(horizon, edfPreemptionTime());
+        return horizon;
+    }
+
+    void stateSignature(vector<Tick>& sig) { sig.push_back(rem_budget); }
+    void saveState(StateWriter& out) { out.put<Tick>(rem_budget); }
+    void loadState(StateReader& in) { rem_budget = in.get<Tick>(); }
+
+    Tick nextReplenishment() {
+        if (rep_period <= 0) return NEVER;
+        return (getCurrentTime() / rep_period + 1) * rep_period;
+    }
+
+    // Under EDF a waiting periodic job takes over from the server as soon as
+    // its deadline falls inside the current replenishment window. Only used
+    // with EDFOrder, where the periodic heap is ordered on deadlines.
+    Tick edfPreemptionTime() {
+        Job* highest_periodic = periodic.top();
+        if(highest_periodic == NULL) return NEVER;
+        return highest_periodic->getAbsDeadline() - rep_period + 1;
+    }
+
+};
+
+// Sporadic server (Sprunt, Sha & Lehoczky). Budget is only given back one
+// replenishment period after it was used: a chunk opens when the server
+// becomes ready (aperiodic work pending and budget left) and closes when it
+// runs out of either; whatever the chunk consumed returns at its activation
+// time plus rep_period. Under EDFOrder the server's deadline is that
+// replenishment time.
+template <class Order>
+class SporadicScheduling final : public Scheduler {
+private:
+    const Tick budget;
+    const Tick rep_period;
+    Tick rem_budget;
+    bool active = false;   // a chunk is open
+    Tick activation = 0; // when the open chunk started
+    Tick consumed = 0;   // budget used by the open chunk
+    std::deque<std::pair<Tick, Tick>> replenishments; // (time, amount), earliest first
+
+    JobHeap<typename Order::Before> periodic; // jobs ordered by the base scheduler
+    JobFifo aperiodic;                        // jobs served first come first served
+
+    static bool isPeriodic(Job* job) { return job->getType() == Periodic || job->getType() == Dynamic; }
+
+    void openChunk() {
+        if (active || rem_budget <= 0 || aperiodic.empty()) return;
+        active = true;
+        activation = getCurrentTime();
+        consumed = 0;
+    }
+    void closeChunk() {
+        if (!active || (rem_budget > 0 && !aperiodic.empty())) return;
+        if (consumed > 0) replenishments.push_back({activation + rep_period, consumed});
+        active = false;
+    }
+
+public:
+    SporadicScheduling(Tick r, Tick b) : Scheduler("Sporadic Server Scheduling"), budget(b), rep_period(r), rem_budget(b) {}
+
+    void addReady(Job* job) {
+        if (isPeriodic(job)) {
+            periodic.push(job);
+            return;
+        }
+        aperiodic.push(job);
+        openChunk();
+    }
+    void removeReady(Job* job) {
+        if (isPeriodic(job)) {
+            periodic.remove(job);
+            return;
+        }
+        aperiodic.remove(job);
+        closeChunk();
+    }
+
+    Job* selectTask() {
+        Job* highest_periodic = periodic.top();
+        if (!active) return highest_periodic;
+        if (highest_periodic && Order::preemptsServer(highest_periodic, rep_period, activation + rep_period)) {
+            return highest_periodic;
+        }
+        return aperiodic.front();
+    }
+
+    Tick budgetReplenishment() {
+        Tick now = getCurrentTime();
+        while (!replenishments.empty() && replenishments.front().first <= now) {
+            rem_budget = std::min(rem_budget + replenishments.front().second, budget);
+            replenishments.pop_front();
+            countBudget(&SimCounters::replenishments);
+        }
+        openChunk();
+        return rem_budget;
+    }
+
+    void execute_server_version(Job* job, Tick t) {
+        if (isPeriodic(job)) {
+            job->execute(t);
+            return;
+        }
+        Tick used = std::min(t, rem_budget);
+        job->execute(used);
+        rem_budget -= used;
+        countBudget(&SimCounters::consumptions, used > 0);
+        countBudget(&SimCounters::consumed, used);
+        consumed += used;
+        closeChunk();
+    }
+
+    Tick getReplenishmentPeriod() { return rep_period; }
+
+    // The server keeps the processor until its budget runs out; replenishments
+    // are events of their own
+    Tick decisionHorizon(Job* selected) {
+        if (isPeriodic(selected)) return NEVER;
+        return getCurrentTime() + rem_budget;
+    }
+
+    Tick nextReplenishment() { return replenishments.empty() ? NEVER : replenishments.front().first; }
+
+    void stateSignature(vector<Tick>& sig) {
+        Tick now = getCurrentTime();
+        sig.push_back(rem_budget);
+        sig.push_back(active ? now - activation : -1);
+        sig.push_back(consumed);
+        for (const auto& r : replenishments) {
+            sig.push_back(r.first - now);
+            sig.push_back(r.second);
+        }
+    }
+
+    void saveState(StateWriter& out) {
+        out.put<Tick>(rem_budget);
+        out.put<uint8_t>(active);
+        out.put<Tick>(activation);
+        out.put<Tick>(consumed);
+        out.put<uint64_t>(replenishments.size());
+        for (const auto& r : replenishments) {
+            out.put<Tick>(r.first);
+            out.put<Tick>(r.second);
+        }
+    }
+    void loadState(StateReader& in) {
+        rem_budget = in.get<Tick>();
+        active = in.get<uint8_t>();
+        activation = in.get<Tick>();
+        consumed = in.get<Tick>();
+        replenishments.clear();
+        for (uint64_t n = in.get<uint64_t>(); n > 0 && in.ok(); n--) {
+            Tick at = in.get<Tick>();
+            replenishments.push_back({at, in.get<Tick>()});
+        }
+    }
+};
+
+// Total bandwidth server (Spuri & Buttazzo), EDF only. The k-th aperiodic
+// request gets the deadline max(r_k, d_{k-1}) + C_k / U_s on arrival, where
+// U_s = budget / period, and then competes with the periodic jobs by that
+// deadline. No budget is tracked: the deadlines alone keep the server at U_s.
+class TBSScheduling final : public Scheduler {
+private:
+    const double bandwidth;
+    double last_deadline = 0; // may fall between ticks
+
+    JobHeap<EarlierDeadline> periodic;
+    JobFifo aperiodic; // deadlines grow with arrival order, so FIFO is EDF order
+
+    static bool isPeriodic(Job* job) { return job->getType() == Periodic || job->getType() == Dynamic; }
+
+public:
+    TBSScheduling(Tick period, Tick budget)
+        : Scheduler("Total Bandwidth Server Scheduling"), bandwidth(period > 0 ? (double)budget / period : 1) {}
+
+    void addReady(Job* job) {
+        if (isPeriodic(job)) {
+            periodic.push(job);
+            return;
+        }
+        // A job with no execution time still runs for one tick
+        Tick work = std::max<Tick>(job->getRem(), 1);
+        last_deadline = std::max((double)getCurrentTime(), last_deadline) + work / bandwidth;
+        job->hook.key = last_deadline;
+        aperiodic.push(job);
+    }
+    void removeReady(Job* job) {
+        if (isPeriodic(job)) periodic.remove(job);
+        else aperiodic.remove(job);
+    }
+
+    Job* selectTask() {
+        Job* highest_periodic = periodic.top();
+        Job* request = aperiodic.front();
+        if (!request) return highest_periodic;
+        if (highest_periodic && highest_periodic->getAbsDeadline() < request->hook.key) return highest_periodic;
+        return request;
+    }
 
-};
\ No newline at end of file
+    void stateSignature(vector<Tick>& sig) {
+        double now = getCurrentTime();
+        sig.push_back(signatureBits(std::max(last_deadline - now, 0.0)));
+        for (Job* job = aperiodic.front(); job; job = job->hook.next) sig.push_back(signatureBits(job->hook.key - now));
+    }
+
+    // addReady() hands out fresh deadlines, so the requests' own come back
+    // from the snapshot in queue order
+    void saveState(StateWriter& out) {
+        out.put<double>(last_deadline);
+        for (Job* job = aperiodic.front(); job; job = job->hook.next) out.put<double>(job->hook.key);
+    }
+    void loadState(StateReader& in) {
+        last_deadline = in.get<double>();
+        for (Job* job = aperiodic.front(); job; job = job->hook.next) job->hook.key = in.get<double>();
+    }
+};
+
+// Constant bandwidth server (Abeni & Buttazzo), EDF only, serving its
+// requests first come first served. The server has a budget and a deadline:
+// a request arriving at an idle server resets both (budget full, deadline
+// r + period) unless what is left could still be spent at the server's
+// bandwidth before the current deadline. An exhausted budget is refilled at
+// once and the deadline postponed by one period.
+class CBSScheduling final : public Scheduler {
+private:
+    const Tick budget;
+    const Tick rep_period;
+    Tick rem_budget = 0;
+    Tick server_deadline = 0;
+
+    JobHeap<EarlierDeadline> periodic;
+    JobFifo aperiodic;
+
+    static bool isPeriodic(Job* job) { return job->getType() == Periodic || job->getType() == Dynamic; }
+
+public:
+    CBSScheduling(Tick r, Tick b) : Scheduler("Constant Bandwidth Server Scheduling"), budget(b), rep_period(r) {}
+
+    void addReady(Job* job) {
+        if (isPeriodic(job)) {
+            periodic.push(job);
+            return;
+        }
+        // rem_budget / (deadline - now) >= budget / rep_period, cross-multiplied
+        Tick now = getCurrentTime();
+        if (aperiodic.empty() && (__int128)rem_budget * rep_period >= (__int128)(server_deadline - now) * budget) {
+            rem_budget = budget;
+            server_deadline = now + rep_period;
+            countBudget(&SimCounters::replenishments);
+        }
+        aperiodic.push(job);
+    }
+    void removeReady(Job* job) {
+        if (isPeriodic(job)) periodic.remove(job);
+        else aperiodic.remove(job);
+    }
+
+    Job* selectTask() {
+        Job* highest_periodic = periodic.top();
+        Job* request = aperiodic.front();
+        if (!request) return highest_periodic;
+        if (highest_periodic && highest_periodic->getAbsDeadline() < server_deadline) return highest_periodic;
+        return request;
+    }
+
+    void execute_server_version(Job* job, Tick t) {
+        job->execute(t);
+        if (isPeriodic(job)) return;
+        rem_budget -= t;
+        countBudget(&SimCounters::consumptions);
+        countBudget(&SimCounters::consumed, t);
+        if (rem_budget <= 0) {
+            rem_budget = budget;
+            server_deadline += rep_period;
+            countBudget(&SimCounters::replenishments);
+        }
+    }
+
+    Tick getReplenishmentPeriod() { return rep_period; }
+
+    // Running out of budget postpones the server's deadline
+    Tick decisionHorizon(Job* selected) {
+        if (isPeriodic(selected)) return NEVER;
+        return getCurrentTime() + rem_budget;
+    }
+
+    void stateSignature(vector<Tick>& sig) {
+        sig.push_back(rem_budget);
+        sig.push_back(server_deadline - getCurrentTime());
+    }
+
+    void saveState(StateWriter& out) {
+        out.put<Tick>(rem_budget);
+        out.put<Tick>(server_deadline);
+    }
+    void loadState(StateReader& in) {
+        rem_budget = in.get<Tick>();
+        server_deadline = in.get<Tick>();
+    }
+};
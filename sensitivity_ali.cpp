@@ -0,0 +1,225 @@
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+
+extern "C" {
+#include "rts_parser.h"
+}
+
+// Sensitivity analysis: how far a task set can be pushed before it stops
+// being schedulable.
+//  - criticalScaling(): the largest factor by which every execution time can
+//    be multiplied with all periodic deadlines still met (the critical
+//    scaling factor of Lehoczky, Sha & Ding).
+//  - serverBudgetRange(): for a polling or deferrable server, the smallest
+//    budget that still serves every job the server handles and the largest
+//    one that leaves every periodic deadline met.
+// Both are binary searches. A probe is decided by the analytical tests when
+// one is conclusive (analysis_ali.cpp) and by a simulation that stops at the
+// first miss otherwise; every probe of a search reuses the same task table
+// and SimRun. The searches take feasibility to be monotone in the searched
+// parameter, which holds for the sustainable policies (RM, DM and EDF under
+// shorter execution times) but is only an approximation for LLF and the
+// servers.
+
+struct SensitivityResult {
+    double value = 0;        // scaling factor, or budget in time units
+    bool bounded = true;     // false: nothing to push (no periodic work)
+    int probes = 0;
+    int simulated = 0;       // probes that needed a simulation
+    std::string decided_by;  // test that decided the last feasible probe, or "simulation"
+    bool clamped = false;    // the simulations stopped at HORIZON_LIMIT
+};
+
+// Feasibility of a periodic set under one policy with every execution time
+// scaled. Works in ticks fine enough for the requested precision.
+class ScalingProbe {
+private:
+    const std::string scheduler;
+    Tick llf_quantum;
+    std::vector<Task> tasks;
+    std::vector<Tick> base;               // unscaled execution times, in ticks
+    std::vector<AnalysedTask> analysed;   // the periodic tasks, in ticks
+    std::vector<size_t> analysed_task;    // their index in `tasks`
+    bool constrained = true;
+    SimHorizon horizon;
+    SimRun run;
+
+public:
+    Tick resolution;
+    SensitivityResult result;
+
+    // `llf_quantum` in time units
+    ScalingProbe(const ParserState* state, const std::string& name, Tick min_resolution, double precision,
+                 double quantum_units)
+        : scheduler(name), llf_quantum(1), resolution(min_resolution) {
+        analysed = analysedTasks(state, constrained);
+        // Fine enough for the smallest execution time to move by one tick
+        // per precision step
+        long long c_min = 0;
+        for (const auto& t : analysed) {
+            long long c = state->tasks[t.index].execution_time;
+            if (c > 0 && (c_min == 0 || c < c_min)) c_min = c;
+        }
+        while (c_min > 0 && resolution < 1000000000LL && (double)resolution * c_min * precision < 1) resolution *= 10;
+        llf_quantum = std::max<Tick>((Tick)std::ceil(quantum_units * resolution), 1);
+
+        loadTasksFromParser(state, tasks, resolution);
+        for (const auto& task : tasks) base.push_back(task.getE());
+        for (auto& t : analysed) {
+            analysed_task.push_back(t.index);
+            t.P *= resolution;
+            t.D *= resolution;
+        }
+        horizon = computeHorizon(state, HORIZON_LIMIT, resolution);
+        result.clamped = horizon.clamped;
+        run.stop_on_miss = true;
+    }
+    ScalingProbe(const ScalingProbe&) = delete;
+    ScalingProbe& operator=(const ScalingProbe&) = delete;
+
+    bool empty() const { return analysed.empty(); }
+
+    // Utilization of the periodic tasks at factor 1
+    double utilization() const {
+        double u = 0;
+        for (size_t k = 0; k < analysed.size(); k++) u += (double)base[analysed_task[k]] / analysed[k].P;
+        return u;
+    }
+
+    bool feasible(double factor) {
+        result.probes++;
+        double u = 0;
+        for (size_t i = 0; i < tasks.size(); i++) tasks[i].setE((Tick)std::floor(factor * base[i]));
+        for (size_t k = 0; k < analysed.size(); k++) {
+            // A job with no execution time still occupies one tick
+            analysed[k].C = std::max<Tick>(tasks[analysed_task[k]].getE(), 1);
+            u += (double)analysed[k].C / analysed[k].P;
+        }
+        if (u > 1.0) return false;
+
+        Analysis verdict = analyzeTasks(analysed, constrained, scheduler);
+        if (verdict.verdict != UNDECIDED) {
+            if (verdict.verdict == SCHEDULABLE) result.decided_by = verdict.test;
+            return verdict.verdict == SCHEDULABLE;
+        }
+        result.simulated++;
+        Scheduler* sch = makePeriodicScheduler(scheduler, llf_quantum);
+        simulate(sch, tasks, horizon, false, nullptr, nullptr, &run);
+        bool met = sch->getMissedDeadlines().empty();
+        delete sch;
+        if (met) result.decided_by = "simulation";
+        return met;
+    }
+};
+
+// Critical scaling factor of the periodic tasks under `scheduler`, to within
+// `precision`. Execution times are scaled in ticks of at least
+// `resolution` per time unit.
+SensitivityResult criticalScaling(const ParserState* state, const std::string& scheduler, Tick resolution,
+                                  double precision, double llf_quantum = 1) {
+    ScalingProbe probe(state, scheduler, resolution, precision, llf_quantum);
+    double u = probe.utilization();
+    if (probe.empty() || u <= 0) {
+        probe.result.bounded = false;
+        return probe.result;
+    }
+    // Beyond 1 / U the utilization exceeds 1
+    double lo = 0, hi = 1.0 / u;
+    if (!probe.feasible(lo)) return probe.result;
+    if (probe.feasible(hi)) {
+        probe.result.value = hi;
+        return probe.result;
+    }
+    while (hi - lo > precision) {
+        double mid = (lo + hi) / 2;
+        if (probe.feasible(mid)) lo = mid;
+        else hi = mid;
+    }
+    probe.result.value = lo;
+    return probe.result;
+}
+
+// Budgets in time units, -1 where no budget up to the server period qualifies
+struct BudgetRange {
+    SensitivityResult smallest; // serving every job the server handles
+    SensitivityResult largest;  // meeting every periodic deadline
+};
+
+// Budget search for the set's polling or deferrable server, in ticks of
+// `resolution`. Both servers handle the aperiodic requests and the dynamic
+// jobs, so more budget helps those and can only hurt the periodic tasks:
+//  - the smallest budget is the least one with which every dynamic job
+//    meets its deadline and every request released within the horizon
+//    completes there
+//    (and, with `response_bound` > 0 time units, that long after its
+//    release);
+//  - the largest budget is the greatest one with every periodic deadline
+//    met.
+// The budget is feasible between the two. Every probe is simulated: the
+// analytical tests do not model the servers.
+BudgetRange serverBudgetRange(const ParserState* state, Tick resolution, double response_bound = 0) {
+    BudgetRange range;
+    ParsedServerConfig config = state->server;
+    std::vector<Task> tasks;
+    loadTasksFromParser(state, tasks, resolution);
+    SimHorizon horizon = computeHorizon(state, HORIZON_LIMIT, resolution);
+    range.smallest.clamped = range.largest.clamped = horizon.clamped;
+    Tick period = config.period * (Tick)resolution;
+    Tick bound = response_bound > 0 ? horizon.ticks(response_bound) : NEVER;
+    SimRun run;
+    ResponseRecorder responses;
+
+    // Whether a run with `budget` meets every deadline on one side: the
+    // periodic tasks, or the server's jobs with every request served
+    auto probe = [&](Tick budget, bool server_side, SensitivityResult& result) {
+        result.probes++;
+        result.simulated++;
+        Scheduler* sch = makeServerScheduler(config, period, budget);
+        simulate(sch, tasks, horizon, true, &responses, nullptr, &run);
+        Span<JobRecord> missed = sch->getMissedDeadlines();
+        bool ok = none_of(missed.begin(), missed.end(),
+                          [&](const JobRecord& job) { return (job.type != Periodic) == server_side; });
+        delete sch;
+        for (size_t i = 0; ok && server_side && i < tasks.size(); i++) {
+            // Requests released past the horizon are never simulated
+            if (tasks[i].getType() != Aperiodic || tasks[i].getR() < 0 || tasks[i].getR() >= horizon.length) continue;
+            const ResponseStats& stats = responses.of(i);
+            ok = stats.count > 0 && stats.max <= bound;
+        }
+        return ok;
+    };
+
+    // Smallest budget in [0, period] that serves everything
+    if (period <= 0 || !probe(period, true, range.smallest)) {
+        range.smallest.value = -1;
+    } else {
+        Tick lo = -1, hi = period;
+        while (hi - lo > 1) {
+            Tick mid = lo + (hi - lo) / 2;
+            if (probe(mid, true, range.smallest)) hi = mid;
+            else lo = mid;
+        }
+        range.smallest.value = (double)hi / resolution;
+        range.smallest.decided_by = "simulation";
+    }
+
+    // Largest budget in [0, period] with every periodic deadline met
+    if (period <= 0 || !probe(0, false, range.largest)) {
+        range.largest.value = -1;
+    } else if (probe(period, false, range.largest)) {
+        range.largest.value = (double)period / resolution;
+        range.largest.decided_by = "simulation";
+    } else {
+        Tick lo = 0, hi = period;
+        while (hi - lo > 1) {
+            Tick mid = lo + (hi - lo) / 2;
+            if (probe(mid, false, range.largest)) lo = mid;
+            else hi = mid;
+        }
+        range.largest.value = (double)lo / resolution;
+        range.largest.decided_by = "simulation";
+    }
+    return range;
+}
@@ -0,0 +1,96 @@
+#include "multicore_ali.cpp"
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "rts_parser.h"
+}
+
+using namespace std;
+
+// Building blocks shared by the simulator front ends (run_ali, sweep_ali):
+// parsed task sets turned into Task objects, and schedulers by name.
+
+// Helper function to convert parsed tasks into C++ Task objects, with times
+// scaled to ticks of the given resolution
+void loadTasksFromParser(const ParserState* state, vector<Task>& tasks, Tick resolution = 1) {
+    tasks.clear();
+    tasks.reserve(state->task_count);
+    for (int i = 0; i < state->task_count; i++) {
+        const ParsedTask* p_task = &state->tasks[i];
+        TaskTypes type;
+        
+        // Map parser task type to C++ enum
+        if (p_task->type == PARSED_TASK_PERIODIC) {
+            type = Periodic;
+        } else if (p_task->type == PARSED_TASK_DYNAMIC) {
+            type = Dynamic;
+        } else { // PARSED_TASK_APERIODIC
+            type = Aperiodic;
+        }
+
+        tasks.emplace_back(
+            type,
+            p_task->execution_time * resolution,
+            p_task->period * resolution,
+            p_task->release_time * resolution,
+            p_task->deadline * resolution
+        );
+        if (p_task->criticality == CRITICALITY_HI) {
+            tasks.back().setCriticality(HiCriticality, p_task->execution_time_hi * resolution);
+        }
+    }
+}
+
+// New periodic-only scheduler by name, or nullptr if there is none. The LLF
+// quantum is in ticks.
+Scheduler* makePeriodicScheduler(const string& name, Tick llf_quantum = 1) {
+    if (name == "RM") return new RMScheduling();
+    if (name == "EDF") return new EDFScheduling();
+    if (name == "LLF") return new LLFScheduling(llf_quantum);
+    if (name == "DM") return new DMScheduling();
+    if (name == "EDF-VD") return new EDFVDScheduling();
+    if (name == "AMC") return new AMCScheduling();
+    return nullptr;
+}
+
+template <class Order>
+Scheduler* makeServerScheduler(ParsedServerType type, Tick period, Tick budget) {
+    switch (type) {
+        case SERVER_POLLER: return new PollerScheduling<Order>(period, budget);
+        case SERVER_DEFERRABLE: return new DeferableScheduling<Order>(period, budget);
+        case SERVER_SPORADIC: return new SporadicScheduling<Order>(period, budget);
+        case SERVER_TBS: return new TBSScheduling(period, budget);
+        case SERVER_CBS: return new CBSScheduling(period, budget);
+        default: return new BackgroundScheduling<Order>();
+    }
+}
+
+// New server scheduler of the class the configuration names, instantiated
+// for its base ordering (EDF unless RM is asked for). Unlike the run_ali
+// front end, which keeps running BACKGROUND sets as deferrable servers,
+// SERVER_BACKGROUND gets BackgroundScheduling. Period and budget are scaled
+// to ticks of the given resolution.
+Scheduler* makeServerScheduler(const ParsedServerConfig& server, Tick resolution = 1) {
+    Tick period = server.period * resolution, budget = server.budget * resolution;
+    if (server.scheduling == SCHED_RM) return makeServerScheduler<RMOrder>(server.type, period, budget);
+    return makeServerScheduler<EDFOrder>(server.type, period, budget);
+}
+
+// The same with the period and budget given in ticks
+Scheduler* makeServerScheduler(const ParsedServerConfig& server, Tick period, Tick budget) {
+    if (server.scheduling == SCHED_RM) return makeServerScheduler<RMOrder>(server.type, period, budget);
+    return makeServerScheduler<EDFOrder>(server.type, period, budget);
+}
+
+const char* const PERIODIC_SCHEDULERS[] = {"RM", "DM", "EDF", "LLF"};
+// Also run on sets with HI-criticality tasks
+const char* const MIXED_CRITICALITY_SCHEDULERS[] = {"EDF-VD", "AMC"};
+
+// Whether a parsed set has HI-criticality tasks
+bool hasHiCriticality(const ParserState& state) {
+    for (int i = 0; i < state.task_count; i++) {
+        if (state.tasks[i].criticality == CRITICALITY_HI) return true;
+    }
+    return false;
+}
@@ -0,0 +1,813 @@
+#include "schedule_ali.cpp"
+#include "horizon_ali.cpp"
+#include "stats_ali.cpp"
+#include "timerwheel_ali.cpp"
+#include <utility>
+#include <optional>
+
+using namespace std;
+
+// Event-driven simulation core shared by the periodic and aperiodic runs.
+//
+// The old loops advanced the clock by 1.0 and rescanned everything on every
+// tick. Here the clock jumps straight to the next instant at which something
+// can change: a job release, the running job's completion, a deadline expiry,
+// a budget replenishment, or the end of the scheduler's current decision
+// (scheduler->decisionHorizon, e.g. LLF crossovers or server budget running
+// out). All of these instants lie on the same tick grid the tick loop used,
+// and at each one the same steps run in the same order (release, deadline
+// check, replenishment, select, execute), so the schedules are identical.
+// Every time is an integer Tick: a release is due when its precomputed time
+// is <= now, one integer compare, however long the run. Releases, deadlines
+// and replenishments wait on a timer wheel, so an event costs the same
+// whatever the number of tasks.
+
+// Where a run stopped, and whether it stopped because its state repeated
+struct SimResult {
+    Tick end;
+    Tick repeat_from = -1;   // earlier hyperperiod boundary with the same state as `end`
+    long events = 0;         // scheduling decisions taken
+    long released = 0;       // jobs released
+    bool checkpointed = false; // stopped at SimCheckpoint::stop_at
+    long preemptions = 0;    // the running job left the processor with work left
+    long switches = 0;       // a job other than the last one was dispatched
+    Tick overhead = 0;       // ticks spent switching (PreemptionConfig::switch_cost)
+    long mode_switches = 0;  // mixed criticality: switches to HI mode
+    long dropped = 0;        // ... LO jobs abandoned in HI mode or not released there
+    double energy = 0;       // speed scaling: power x ticks (PlatformConfig::power)
+    SimCounters counters;    // with RTS_INSTRUMENT, what the run counted (see instrument_ali.cpp)
+};
+
+// Splitting a run: it can start from a snapshot instead of t = 0, and stop
+// at its first event at or after `stop_at`, leaving a snapshot behind (a run
+// that ends sooner leaves its final state). Resuming a snapshot continues
+// exactly where the run left off, with the trace and statistics of the part
+// already simulated.
+struct SimCheckpoint {
+    string resume_from;     // snapshot to continue, "" to start at t = 0
+    string save_to;         // where the snapshot goes when the run stops
+    Tick stop_at = NEVER;
+    string error;           // why a snapshot could not be read or written, if so
+    bool resumed = false;   // resume_from was loaded
+    bool saved = false;     // save_to was written
+};
+
+// First release of a periodic or dynamic task: the first multiple of its
+// period at or after its release time
+inline Tick firstRelease(const Task& task) {
+    Tick r = max<Tick>(task.getR(), 0);
+    return (r + task.getP() - 1) / task.getP() * task.getP();
+}
+
+// Released jobs in release order, as the state signature needs them. Jobs
+// that leave (complete or miss their deadline) are only marked retired;
+// they go back to the pool in one sweep once they make up half the list, so
+// no event has to walk the jobs and each job costs O(1) amortized.
+class LiveJobs {
+private:
+    JobPool& pool;
+    vector<Job*> jobs;
+    size_t retired = 0;
+
+    void sweep() {
+        size_t kept = 0;
+        for (Job* job : jobs) {
+            if (job->isRetired()) pool.destroy(job);
+            else jobs[kept++] = job;
+        }
+        jobs.resize(kept);
+        retired = 0;
+    }
+
+public:
+    LiveJobs(JobPool& p) : pool(p) {}
+    LiveJobs(const LiveJobs&) = delete;
+    LiveJobs& operator=(const LiveJobs&) = delete;
+    ~LiveJobs() { clear(); }
+
+    // Hands every job back to the pool
+    void clear() {
+        for (Job* job : jobs) pool.destroy(job);
+        jobs.clear();
+        retired = 0;
+    }
+
+    void push(Job* job) { jobs.push_back(job); }
+    void retire(Job* job) {
+        job->retire();
+        if (++retired * 2 > jobs.size()) sweep();
+    }
+    // Includes retired jobs not swept yet
+    const vector<Job*>& all() const { return jobs; }
+};
+
+enum TimerKind { RELEASE_TIMER, DEADLINE_TIMER, REPLENISH_TIMER };
+
+// The timers due at one event, sorted the way the simulator handles them:
+// releases in task order and deadline misses in release order at equal
+// times
+struct DueTimers {
+    vector<TimerNode*> all, releases, deadlines;
+    bool replenish = false;
+
+    void collect(TimerWheel& wheel, Tick now) {
+        all.clear();
+        releases.clear();
+        deadlines.clear();
+        replenish = false;
+        wheel.advance(now, all);
+        for (TimerNode* node : all) {
+            if (node->kind == RELEASE_TIMER) releases.push_back(node);
+            else if (node->kind == DEADLINE_TIMER) deadlines.push_back(node);
+            else replenish = true;
+        }
+        if (releases.size() > 1) {
+            sort(releases.begin(), releases.end(), [](TimerNode* a, TimerNode* b) {
+                return a->when != b->when ? a->when < b->when : a->task < b->task;
+            });
+        }
+        if (deadlines.size() > 1) {
+            sort(deadlines.begin(), deadlines.end(), [](TimerNode* a, TimerNode* b) {
+                return a->when != b->when ? a->when < b->when : a->job->hook.seq < b->job->hook.seq;
+            });
+        }
+    }
+};
+
+// One release timer per task, not armed yet
+static void initReleaseTimers(vector<TimerNode>& release_timers, const vector<Task>& tasks) {
+    release_timers.assign(tasks.size(), TimerNode());
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        release_timers[i].kind = RELEASE_TIMER;
+        release_timers[i].task = i;
+    }
+}
+
+// One release timer per task, armed for its first release
+static void armReleases(TimerWheel& timers, vector<TimerNode>& release_timers, const vector<Task>& tasks,
+                        bool serve_aperiodic, int& one_shot) {
+    initReleaseTimers(release_timers, tasks);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        const auto& task = tasks[i];
+        if (task.getType() == Periodic || task.getType() == Dynamic) {
+            // Jobs are released on multiples of the period once the release time has passed
+            if (task.getP() > 0) timers.insert(&release_timers[i], firstRelease(task));
+        } else if (serve_aperiodic && task.getR() >= 0) {
+            timers.insert(&release_timers[i], task.getR());
+            one_shot++;
+        }
+    }
+}
+
+// Keeps `timer` on the scheduler's next replenishment. A replenishment that
+// is already due (a sporadic server chunk can close more than a period after
+// it opened) fires at `now`. With `earlier_only` the timer is only brought
+// forward: executing can schedule a new replenishment (a sporadic server
+// does when a chunk closes) but never cancels one that is pending.
+template <class S>
+static void armReplenishment(S* sch, TimerWheel& timers, TimerNode& timer, Tick now, bool earlier_only = false) {
+    Tick at = sch->nextReplenishment();
+    if (at == NEVER) {
+        if (!earlier_only) timers.remove(&timer);
+        return;
+    }
+    at = max(at, now);
+    if (timer.level < 0 || at < timer.when || (!earlier_only && at != timer.when)) timers.insert(&timer, at);
+}
+
+// Watches a periodic or dynamic job's deadline
+static void armDeadline(TimerWheel& timers, Job* job) {
+    job->deadline_timer.kind = DEADLINE_TIMER;
+    job->deadline_timer.job = job;
+    timers.insert(&job->deadline_timer, job->getAbsDeadline());
+}
+
+// Everything that determines the schedule from time `now` on, given that the
+// release pattern is periodic: the live jobs in release order (task, age,
+// remaining work) and the scheduler's own state, e.g. a server budget.
+template <class S>
+static void stateSignature(S* sch, const vector<Task>& tasks, const vector<Job*>& queued_jobs,
+                           Tick now, vector<Tick>& sig) {
+    sig.clear();
+    for (Job* job : queued_jobs) {
+        if (job->isRetired()) continue;
+        sig.push_back(job->getTask() - tasks.data());
+        sig.push_back(now - job->getJobReleaseTime());
+        sig.push_back(job->getRem());
+    }
+    sch->stateSignature(sig);
+}
+
+// Identifies what a snapshot belongs to: the scheduler, the task table in
+// ticks and whether aperiodic jobs are served
+static uint64_t runDigest(Scheduler* sch, const vector<Task>& tasks, bool serve_aperiodic) {
+    string name = sch->getName();
+    uint64_t hash = stateHash(name.data(), name.size());
+    hash = stateHash(&serve_aperiodic, sizeof(serve_aperiodic), hash);
+    const PreemptionConfig& preemption = sch->getPreemption();
+    Tick modes[] = {preemption.mode, preemption.threshold_levels, preemption.deferral, preemption.switch_cost};
+    hash = stateHash(modes, sizeof(modes), hash);
+    const PlatformConfig& platform = sch->getPlatform();
+    double settings[] = {(double)platform.overrun_at, (double)platform.dvfs, platform.speed, platform.static_power};
+    hash = stateHash(settings, sizeof(settings), hash);
+    hash = stateHash(platform.speeds.data(), platform.speeds.size() * sizeof(double), hash);
+    for (const auto& task : tasks) {
+        Tick fields[] = {task.getType(), task.getE(), task.getP(), task.getR(), task.getD(), task.getCriticality(),
+                         task.getEHi()};
+        hash = stateHash(fields, sizeof(fields), hash);
+    }
+    return hash;
+}
+
+// Everything the simulation loop carries from one event to the next. A
+// caller that simulates many variants of a set can hand the same SimRun to
+// every simulate() call, which keeps the job slabs and buffers allocated.
+struct SimRun {
+    // Ends the run at the first deadline miss, for callers that only ask
+    // whether there is one. Kept across reset().
+    bool stop_on_miss = false;
+
+    JobPool pool;
+    LiveJobs live{pool};
+    long released = 0;
+    int one_shot = 0; // aperiodic releases still pending
+
+    TimerWheel timers;
+    vector<TimerNode> release_timers;
+    // The scheduler's next replenishment. budgetReplenishment() only runs at
+    // the first decision and when this fires.
+    TimerNode replenish_timer;
+    bool replenish = true;
+
+    // Hyperperiod boundaries at which the state is compared with the earlier ones
+    Tick next_boundary = NEVER;
+    StateHistory history;
+
+    // Limited preemption and switch overhead (see PreemptionConfig)
+    Job* running = NULL;   // job dispatched last, while it has work left
+    Job* loaded = NULL;    // job whose context the processor holds, while it is live
+    Tick overhead = 0;     // switch overhead still due before `loaded` runs
+    Tick preempt_at = -1;  // deferred preemption: when the pending one may happen, -1 if none
+    vector<int> level, threshold; // preemption threshold: per task
+
+    // Mixed criticality and speed scaling (see PlatformConfig)
+    bool high = false;     // HI-criticality mode
+    double speed = 1;      // current processor speed
+    vector<double> claimed; // cycle-conserving EDF: utilization per task
+
+    // Back to the state of a run that has not started
+    void reset() {
+        live.clear();
+        released = 0;
+        one_shot = 0;
+        timers.clear();
+        release_timers.clear();
+        replenish_timer = TimerNode();
+        replenish_timer.kind = REPLENISH_TIMER;
+        replenish = true;
+        next_boundary = NEVER;
+        history.clear();
+        running = loaded = NULL;
+        overhead = 0;
+        preempt_at = -1;
+        high = false;
+        speed = 1;
+        claimed.clear();
+    }
+
+    // Ticks that `work` ticks of full-speed execution take at the current speed
+    Tick atSpeed(Tick work) const { return speed == 1 ? work : (Tick)ceil(work / speed - 1e-9); }
+
+    // Execution time `job` really has, in full-speed ticks: HI jobs overrun
+    // their LO one from platform.overrun_at on
+    static Tick demand(Job* job, const PlatformConfig& platform) {
+        const Task* task = job->getTask();
+        bool overrun = task->getCriticality() == HiCriticality && job->getJobReleaseTime() >= platform.overrun_at;
+        return overrun ? task->getEHi() : task->getE();
+    }
+
+    // Sets up a job just released, before the scheduler sees it
+    template <class S>
+    void start(S* sch, Job* job, const PlatformConfig& platform) {
+        Tick work = demand(job, platform);
+        Tick rem = atSpeed(work);
+        if (rem != job->getRem()) job->restore(rem, false);
+        if (sch->mixedCriticality() && work > job->getTask()->getE()) {
+            Tick budget_end = rem - atSpeed(job->getTask()->getE());
+            job->lo_budget_end = budget_end > 0 ? budget_end : -1;
+        }
+    }
+
+    // Utilization a task claims for cycle-conserving EDF: its largest
+    // execution time over its deadline window, or `work` once its job is done
+    static double claim(const Task& task, Tick work) {
+        return (double)work / min(task.getD(), task.getP());
+    }
+
+    void claimAll(const vector<Task>& tasks) {
+        claimed.assign(tasks.size(), 0);
+        for (size_t i = 0; i < tasks.size(); i++) {
+            if (tasks[i].getType() != Aperiodic && tasks[i].getP() > 0) claimed[i] = claim(tasks[i], tasks[i].getEHi());
+        }
+    }
+
+    double claimedUtilization() const {
+        double u = 0;
+        for (double c : claimed) u += c;
+        return u;
+    }
+
+    // Changes the processor speed: the work live jobs have left takes
+    // proportionally longer or shorter, rounded up to ticks
+    void setSpeed(double next) {
+        if (next == speed) return;
+        auto stretch = [&](Tick t) { return (Tick)ceil(t * speed / next - 1e-9); };
+        for (Job* job : live.all()) {
+            if (job->isRetired()) continue;
+            job->restore(stretch(job->getRem()), job->hasStarted());
+            if (job->lo_budget_end >= 0) job->lo_budget_end = stretch(job->lo_budget_end);
+        }
+        speed = next;
+    }
+
+    // Preemption levels and thresholds of the tasks, with `config`
+    template <class S>
+    void setLevels(S* sch, const vector<Task>& tasks, const PreemptionConfig& config) {
+        level.clear();
+        threshold.clear();
+        if (config.mode != PREEMPTION_THRESHOLD) return;
+        vector<Tick> keys;
+        for (const auto& task : tasks) keys.push_back(sch->preemptionKey(task));
+        vector<Tick> ranks = keys;
+        sort(ranks.begin(), ranks.end());
+        ranks.erase(unique(ranks.begin(), ranks.end()), ranks.end());
+        for (Tick key : keys) {
+            int l = lower_bound(ranks.begin(), ranks.end(), key) - ranks.begin();
+            level.push_back(l);
+            threshold.push_back(max(l - config.threshold_levels, 0));
+        }
+    }
+
+    // Whether the mode lets `job` take the processor from `running` at
+    // `now`. A deferred preemption becomes due `deferral` ticks after it is
+    // first asked for.
+    bool mayPreempt(const PreemptionConfig& config, Job* job, Tick now, const vector<Task>& tasks) {
+        switch (config.mode) {
+            case NON_PREEMPTIVE: return false;
+            case PREEMPTION_THRESHOLD:
+                return job && level[job->getTask() - tasks.data()] < threshold[running->getTask() - tasks.data()];
+            case DEFERRED_PREEMPTION:
+                if (preempt_at < 0) preempt_at = now + config.deferral;
+                return now >= preempt_at;
+            default: return true;
+        }
+    }
+
+    // `job` completed or missed its deadline
+    void left(Job* job) {
+        if (job == running) {
+            running = NULL;
+            preempt_at = -1;
+        }
+        if (job == loaded) {
+            loaded = NULL;
+            overhead = 0;
+        }
+    }
+
+    // The state signature (see stateSignature), with the engine's own
+    // preemption state when the run limits preemption or pays for switches,
+    // and its criticality mode and speed when it has them
+    template <class S>
+    void signature(S* sch, const vector<Task>& tasks, const vector<Job*>& jobs, Tick now, vector<Tick>& sig) {
+        stateSignature(sch, tasks, jobs, now, sig);
+        if (sch->mixedCriticality() || sch->getPlatform().scaling()) {
+            sig.push_back(high);
+            sig.push_back(signatureBits(speed));
+            for (double c : claimed) sig.push_back(signatureBits(c));
+            for (Job* job : jobs) {
+                if (!job->isRetired() && job->lo_budget_end >= 0) sig.push_back(job->getRem() - job->lo_budget_end);
+            }
+        }
+        const PreemptionConfig& config = sch->getPreemption();
+        if (!config.limited() && config.switch_cost == 0) return;
+        for (Job* job : {running, loaded}) {
+            sig.push_back(job ? job->getTask() - tasks.data() : -1);
+            sig.push_back(job ? now - job->getJobReleaseTime() : -1);
+        }
+        sig.push_back(overhead);
+        sig.push_back(preempt_at < 0 ? -1 : preempt_at - now);
+    }
+
+    // Live jobs in release order
+    void liveJobs(vector<Job*>& jobs) {
+        jobs.clear();
+        for (Job* job : live.all()) {
+            if (!job->isRetired()) jobs.push_back(job);
+        }
+    }
+
+    template <class S>
+    vector<unsigned char> save(S* sch, const vector<Task>& tasks, bool serve_aperiodic, ResponseRecorder* responses,
+                               const SimResult& result) {
+        StateWriter out;
+        vector<Job*> jobs;
+        liveJobs(jobs);
+        out.setJobs(jobs);
+        out.put<uint64_t>(runDigest(sch, tasks, serve_aperiodic));
+        out.put<int64_t>(released);
+        out.put<int64_t>(result.events);
+        out.put<int32_t>(one_shot);
+        out.put<uint8_t>(replenish);
+        out.put<Tick>(replenish_timer.level >= 0 ? replenish_timer.when : -1);
+        out.put<Tick>(next_boundary);
+        for (const TimerNode& timer : release_timers) out.put<Tick>(timer.level >= 0 ? timer.when : -1);
+
+        sch->saveTrace(out);
+        out.put<uint64_t>(jobs.size());
+        for (Job* job : jobs) {
+            out.put<uint64_t>(job->getTask() - tasks.data());
+            out.put<int64_t>(job->hook.seq);
+            out.put<Tick>(job->getJobReleaseTime());
+            out.put<Tick>(job->getRem());
+            out.put<uint8_t>(job->hasStarted());
+            out.put<Tick>(job->lo_budget_end);
+        }
+        sch->saveState(out);
+        history.save(out);
+        out.putJob(running);
+        out.putJob(loaded);
+        out.put<Tick>(overhead);
+        out.put<Tick>(preempt_at);
+        out.put<int64_t>(result.preemptions);
+        out.put<int64_t>(result.switches);
+        out.put<Tick>(result.overhead);
+        out.put<uint8_t>(high);
+        out.put<double>(speed);
+        out.put<uint64_t>(claimed.size());
+        for (double c : claimed) out.put<double>(c);
+        out.put<int64_t>(result.mode_switches);
+        out.put<int64_t>(result.dropped);
+        out.put<double>(result.energy);
+
+        out.put<uint8_t>(responses != nullptr);
+        if (responses) {
+            for (size_t i = 0; i < tasks.size(); i++) {
+                const ResponseStats& stats = responses->of(i);
+                out.put<uint64_t>(stats.count);
+                out.put<double>(stats.min);
+                out.put<double>(stats.max);
+                out.put<double>(stats.sum);
+                const vector<uint64_t>& buckets = stats.histogram.buckets();
+                out.put<uint64_t>(count_if(buckets.begin(), buckets.end(), [](uint64_t n) { return n > 0; }));
+                for (size_t b = 0; b < buckets.size(); b++) {
+                    if (buckets[b] == 0) continue;
+                    out.put<uint32_t>(b);
+                    out.put<uint64_t>(buckets[b]);
+                }
+            }
+        }
+
+        // Checked after a resume: the state rebuilt must be the one left here
+        vector<Tick> sig;
+        signature(sch, tasks, jobs, sch->getCurrentTime(), sig);
+        out.put<uint64_t>(stateHash(sig));
+        return out.data();
+    }
+
+    // Rebuilds the run from a snapshot payload on a freshly prepared
+    // scheduler. Returns "" or why the snapshot does not fit.
+    template <class S>
+    string load(const vector<unsigned char>& payload, S* sch, const vector<Task>& tasks, bool serve_aperiodic,
+                ResponseRecorder* responses, SimResult& result) {
+        StateReader in(payload);
+        if (in.get<uint64_t>() != runDigest(sch, tasks, serve_aperiodic)) {
+            return "snapshot of another task set or scheduler";
+        }
+        released = in.get<int64_t>();
+        result.events = in.get<int64_t>();
+        one_shot = in.get<int32_t>();
+        replenish = in.get<uint8_t>();
+        Tick replenish_at = in.get<Tick>();
+        if (replenish_at >= 0) timers.insert(&replenish_timer, replenish_at);
+        next_boundary = in.get<Tick>();
+        for (TimerNode& timer : release_timers) {
+            Tick at = in.get<Tick>();
+            if (at >= 0) timers.insert(&timer, at);
+        }
+
+        // The clock comes first: the schedulers look at it while jobs are added
+        sch->loadTrace(in);
+        vector<Job*> jobs;
+        for (uint64_t n = in.get<uint64_t>(); n > 0 && in.ok(); n--) {
+            uint64_t task = in.get<uint64_t>();
+            long seq = in.get<int64_t>();
+            Tick release = in.get<Tick>();
+            Tick rem = in.get<Tick>();
+            bool started = in.get<uint8_t>();
+            Tick budget_end = in.get<Tick>();
+            if (task >= tasks.size() || seq >= released) return "corrupt snapshot (bad job)";
+            Job* job = pool.create(&tasks[task], release, seq);
+            job->restore(rem, started);
+            job->lo_budget_end = budget_end;
+            live.push(job);
+            jobs.push_back(job);
+            sch->addReady(job);
+            if (job->getType() != Aperiodic) armDeadline(timers, job);
+        }
+        in.setJobs(jobs);
+        sch->loadState(in);
+        history.load(in);
+        running = in.getJob();
+        loaded = in.getJob();
+        overhead = in.get<Tick>();
+        preempt_at = in.get<Tick>();
+        result.preemptions = in.get<int64_t>();
+        result.switches = in.get<int64_t>();
+        result.overhead = in.get<Tick>();
+        high = in.get<uint8_t>();
+        speed = in.get<double>();
+        uint64_t claims = in.get<uint64_t>();
+        if (claims != 0 && claims != tasks.size()) return "corrupt snapshot (bad layout)";
+        claimed.resize(claims);
+        for (double& c : claimed) c = in.get<double>();
+        result.mode_switches = in.get<int64_t>();
+        result.dropped = in.get<int64_t>();
+        result.energy = in.get<double>();
+
+        if (in.get<uint8_t>() && responses) {
+            for (size_t i = 0; i < tasks.size() && in.ok(); i++) {
+                ResponseStats& stats = responses->of(i);
+                stats.count = in.get<uint64_t>();
+                stats.min = in.get<double>();
+                stats.max = in.get<double>();
+                stats.sum = in.get<double>();
+                for (uint64_t n = in.get<uint64_t>(); n > 0 && in.ok(); n--) {
+                    uint32_t b = in.get<uint32_t>();
+                    stats.histogram.setBucket(b, in.get<uint64_t>());
+                }
+            }
+        }
+        uint64_t expected = in.get<uint64_t>();
+        if (!in.ok() || !in.atEnd()) return "corrupt snapshot (bad layout)";
+        vector<Tick> sig;
+        signature(sch, tasks, jobs, sch->getCurrentTime(), sig);
+        if (stateHash(sig) != expected) return "snapshot does not restore the state it was taken in";
+        return "";
+    }
+};
+
+// Runs `sch` over [0, horizon.length) ticks. Aperiodic tasks are only released when
+// serve_aperiodic is set; they never count as deadline misses.
+// Instantiated for the scheduler's concrete (final) class, every scheduler
+// call in the loop is a direct call the compiler can inline; simulate()
+// below picks the instantiation at run time.
+// With `responses` set, the response time of every completed job is recorded
+// under its task's index. With `checkpoint` set, the run may start from a
+// snapshot and stop into one; a snapshot that cannot be read or written
+// ends the run with checkpoint->error set. `workspace`, if given, is reset
+// and used instead of a fresh SimRun.
+template <class S>
+SimResult simulateAs(S* sch, const vector<Task>& tasks, const SimHorizon& horizon, bool serve_aperiodic,
+                     ResponseRecorder* responses, SimCheckpoint* checkpoint, SimRun* workspace) {
+    const Tick sim_length = horizon.length;
+    optional<SimRun> own;
+    if (!workspace) workspace = &own.emplace();
+    SimRun& run = *workspace;
+    run.reset();
+    sch->prepare(tasks);
+    const PreemptionConfig& preemption = sch->getPreemption();
+    const bool limited = preemption.limited();
+    run.setLevels(sch, tasks, preemption);
+    const PlatformConfig& platform = sch->getPlatform();
+    if (platform.dvfs == DVFS_STATIC) run.speed = platform.speed;
+    if (platform.dvfs == DVFS_CYCLE_CONSERVING) run.claimAll(tasks);
+    if (responses) responses->reset(tasks.size());
+    DueTimers due;
+
+    SimResult result;
+    Tick stop_at = checkpoint ? checkpoint->stop_at : NEVER;
+    if (checkpoint && !checkpoint->resume_from.empty()) {
+        initReleaseTimers(run.release_timers, tasks);
+        vector<unsigned char> payload;
+        checkpoint->error = readSnapshotFile(checkpoint->resume_from, payload);
+        if (checkpoint->error.empty()) {
+            checkpoint->error = run.load(payload, sch, tasks, serve_aperiodic, responses, result);
+        }
+        if (!checkpoint->error.empty()) {
+            result.end = sch->getCurrentTime();
+            return result;
+        }
+        checkpoint->resumed = true;
+    } else {
+        armReleases(run.timers, run.release_timers, tasks, serve_aperiodic, run.one_shot);
+        run.next_boundary = horizon.hyperperiod > 0 ? horizon.offset : NEVER;
+    }
+
+    vector<Tick> current;
+    SimProbe probe;
+
+    while (sch->getCurrentTime() < sim_length) {
+        Tick current_time = sch->getCurrentTime();
+        probe.phase(PHASE_OTHER);
+
+        if (current_time >= stop_at) {
+            result.checkpointed = true;
+            break;
+        }
+
+        if (current_time >= run.next_boundary) {
+            // Only meaningful once every one-shot release is behind us, and
+            // every HI-criticality job to come overruns
+            if (run.one_shot == 0 && (platform.overrun_at == NEVER || current_time >= platform.overrun_at)) {
+                run.signature(sch, tasks, run.live.all(), current_time, current);
+                Tick seen = run.history.find(current);
+                if (seen >= 0) {
+                    result.repeat_from = seen;
+                    break;
+                }
+                run.history.add(current_time, current);
+            }
+            run.next_boundary += horizon.hyperperiod;
+        }
+
+        armReplenishment(sch, run.timers, run.replenish_timer, current_time, true);
+        probe.phase(PHASE_RELEASE);
+        due.collect(run.timers, current_time);
+
+        // Release jobs that are due
+        probe.count(&SimCounters::releases, due.releases.size());
+        for (TimerNode* timer : due.releases) {
+            const auto& task = tasks[timer->task];
+            if (run.high && task.getCriticality() == LoCriticality && task.getType() != Aperiodic) {
+                // HI mode releases no LO job
+                result.dropped++;
+                if (!run.claimed.empty()) run.claimed[timer->task] = 0;
+                run.timers.insert(timer, current_time + task.getP());
+                continue;
+            }
+            Job* job = run.pool.create(&task, current_time, run.released++);
+            run.start(sch, job, platform);
+            if (!run.claimed.empty() && task.getType() != Aperiodic) {
+                run.claimed[timer->task] = SimRun::claim(task, task.getEHi());
+            }
+            run.live.push(job);
+            sch->addReady(job);
+            if (task.getType() != Aperiodic) {
+                armDeadline(run.timers, job);
+                run.timers.insert(timer, current_time + task.getP());
+            } else {
+                run.one_shot--;
+            }
+        }
+
+        // Deadline misses (only for non-aperiodic tasks): every job whose
+        // deadline has come leaves at once, the rest wait for theirs
+        probe.phase(PHASE_MISS_CHECK);
+        probe.count(&SimCounters::deadline_checks);
+        for (TimerNode* timer : due.deadlines) {
+            Job* job = timer->job;
+            sch->addMissedDeadline(job);
+            sch->removeReady(job);
+            probe.left(job);
+            run.left(job);
+            run.live.retire(job);
+        }
+        if (run.stop_on_miss && !due.deadlines.empty()) break;
+
+        // Replenish server budget if applicable
+        probe.phase(PHASE_SELECT);
+        if (run.replenish || due.replenish) sch->budgetReplenishment();
+        run.replenish = false;
+        armReplenishment(sch, run.timers, run.replenish_timer, current_time);
+
+        Tick next_event = min(min(sim_length, min(run.next_boundary, stop_at)), run.timers.nextExpiry());
+        if (!run.claimed.empty()) run.setSpeed(platform.speedFor(run.claimedUtilization()));
+
+        // Select and run the job until the next event
+        result.events++;
+        probe.count(&SimCounters::selects);
+        Job* now = sch->selectTask();
+        if (run.running && now != run.running) {
+            // The running job would leave with work left
+            if (limited && !run.mayPreempt(preemption, now, current_time, tasks)) {
+                now = run.running;
+            } else {
+                result.preemptions++;
+                run.preempt_at = -1;
+            }
+        } else {
+            run.preempt_at = -1;
+        }
+        probe.dispatch(0, now);
+        probe.phase(PHASE_EXECUTE);
+        if (now) {
+            sch->addLog(now);
+            if (now != run.loaded) {
+                run.loaded = now;
+                run.overhead = preemption.switch_cost;
+                result.switches++;
+            }
+            next_event = min(next_event, current_time + run.overhead + max<Tick>(1, now->getRem()));
+            if (!run.high && now->lo_budget_end >= 0) {
+                // The job overruns its LO execution time
+                next_event = min(next_event, current_time + run.overhead + max<Tick>(1, now->getRem() - now->lo_budget_end));
+            }
+            next_event = min(next_event, sch->decisionHorizon(now));
+            if (run.preempt_at >= 0) next_event = min(next_event, run.preempt_at);
+            // The switch overhead is paid first
+            Tick dt = next_event - current_time;
+            Tick charged = min(run.overhead, dt);
+            run.overhead -= charged;
+            result.overhead += charged;
+            if (dt > charged) sch->execute_server_version(now, dt - charged);
+            run.running = now;
+            if (platform.scaling()) result.energy += platform.power(run.speed) * dt;
+
+            if (dt > charged && now->isComplete()) {
+                if (responses) responses->record(now->getTask() - tasks.data(), next_event - now->getJobReleaseTime());
+                if (!run.claimed.empty()) {
+                    run.claimed[now->getTask() - tasks.data()] = SimRun::claim(*now->getTask(), SimRun::demand(now, platform));
+                }
+                sch->removeReady(now);
+                sch->addFinishedJob(now);
+                run.timers.remove(&now->deadline_timer);
+                probe.left(now);
+                run.left(now);
+                run.live.retire(now);
+            } else if (!run.high && now->lo_budget_end >= 0 && now->getRem() <= now->lo_budget_end) {
+                // Switch to HI mode: every LO job leaves
+                run.high = true;
+                result.mode_switches++;
+                vector<Job*> lo;
+                for (Job* job : run.live.all()) {
+                    if (!job->isRetired() && job->getTask()->getCriticality() == LoCriticality) lo.push_back(job);
+                }
+                for (Job* job : lo) {
+                    sch->removeReady(job);
+                    run.timers.remove(&job->deadline_timer);
+                    probe.left(job);
+                    run.left(job);
+                    run.live.retire(job);
+                    result.dropped++;
+                }
+                sch->criticalityChange(true);
+            }
+        } else {
+            sch->addLog(nullptr); // Log IDLE time
+            run.running = NULL;
+            if (platform.scaling()) result.energy += platform.static_power * (next_event - current_time);
+            if (run.high) {
+                // Back to LO mode at the first idle instant
+                run.high = false;
+                sch->criticalityChange(false);
+            }
+        }
+        sch->clockTick(next_event - current_time);
+    }
+
+    result.end = sch->getCurrentTime();
+    result.released = run.released;
+    result.counters = probe.finish();
+    if (checkpoint && !checkpoint->save_to.empty()) {
+        checkpoint->error = writeSnapshotFile(checkpoint->save_to,
+                                              run.save(sch, tasks, serve_aperiodic, responses, result));
+        checkpoint->saved = checkpoint->error.empty();
+    }
+    return result;
+}
+
+// The scheduler classes simulate() has a devirtualized loop for
+template <class... S>
+struct SchedulerClasses {};
+
+typedef SchedulerClasses<RMScheduling, DMScheduling, EDFScheduling, LLFScheduling,
+                         BackgroundScheduling<RMOrder>, BackgroundScheduling<EDFOrder>,
+                         PollerScheduling<RMOrder>, PollerScheduling<EDFOrder>,
+                         DeferableScheduling<RMOrder>, DeferableScheduling<EDFOrder>,
+                         SporadicScheduling<RMOrder>, SporadicScheduling<EDFOrder>,
+                         TBSScheduling, CBSScheduling, EDFVDScheduling, AMCScheduling> SimulatedClasses;
+
+template <class First, class... Rest>
+SimResult simulateAny(SchedulerClasses<First, Rest...>, Scheduler* sch, const vector<Task>& tasks,
+                      const SimHorizon& horizon, bool serve_aperiodic, ResponseRecorder* responses,
+                      SimCheckpoint* checkpoint, SimRun* workspace) {
+    if (First* concrete = dynamic_cast<First*>(sch)) {
+        return simulateAs(concrete, tasks, horizon, serve_aperiodic, responses, checkpoint, workspace);
+    }
+    return simulateAny(SchedulerClasses<Rest...>(), sch, tasks, horizon, serve_aperiodic, responses, checkpoint,
+                       workspace);
+}
+
+// Any other class runs the same loop through virtual calls
+inline SimResult simulateAny(SchedulerClasses<>, Scheduler* sch, const vector<Task>& tasks,
+                             const SimHorizon& horizon, bool serve_aperiodic, ResponseRecorder* responses,
+                             SimCheckpoint* checkpoint, SimRun* workspace) {
+    return simulateAs(sch, tasks, horizon, serve_aperiodic, responses, checkpoint, workspace);
+}
+
+SimResult simulate(Scheduler* sch, const vector<Task>& tasks, const SimHorizon& horizon, bool serve_aperiodic,
+                   ResponseRecorder* responses = nullptr, SimCheckpoint* checkpoint = nullptr,
+                   SimRun* workspace = nullptr) {
+    return simulateAny(SimulatedClasses(), sch, tasks, horizon, serve_aperiodic, responses, checkpoint, workspace);
+}
@@ -0,0 +1,222 @@
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <unordered_map>
+
+// Simulator snapshots: the complete state of a run written to a compact
+// binary file, from which the run can be resumed as if it never stopped.
+// Layout:
+//
+//   "RTSSNAP1", uint32_t version, uint32_t payload size
+//   payload (see simulateAs), uint64_t stateHash of the payload
+//
+// Fields are fixed-width in the byte order of the machine that wrote the
+// file, like the task batches (rts_batch.h); the version doubles as a
+// byte-order check.
+
+#define SNAPSHOT_MAGIC "RTSSNAP1"
+const uint32_t SNAPSHOT_VERSION = 4;
+
+// FNV-1a, 64 bit
+inline uint64_t stateHash(const void* data, size_t size, uint64_t hash = 14695981039346656037ULL) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+inline uint64_t stateHash(const std::vector<Tick>& values) {
+    return stateHash(values.data(), values.size() * sizeof(Tick));
+}
+
+// A state signature entry for a field that is not a whole number of ticks
+// (a speed, a utilization): its exact bits, 0 and -0 alike
+inline Tick signatureBits(double value) {
+    if (value == 0) value = 0;
+    Tick bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Appends fixed-width fields to a payload. Jobs are written by their index
+// among the live jobs the snapshot lists (setJobs), in release order.
+class StateWriter {
+private:
+    std::vector<unsigned char> bytes;
+    std::vector<long> seqs; // release order of the listed jobs, ascending
+
+public:
+    template <class T>
+    void put(T value) {
+        const unsigned char* p = (const unsigned char*)&value;
+        bytes.insert(bytes.end(), p, p + sizeof(T));
+    }
+    void putString(const std::string& s) {
+        put<uint32_t>(s.size());
+        bytes.insert(bytes.end(), s.begin(), s.end());
+    }
+    void setJobs(const std::vector<Job*>& jobs) {
+        seqs.clear();
+        for (Job* job : jobs) seqs.push_back(job->hook.seq);
+    }
+    // -1 for no job
+    void putJob(Job* job) {
+        long index = -1;
+        if (job) index = std::lower_bound(seqs.begin(), seqs.end(), job->hook.seq) - seqs.begin();
+        put<int64_t>(index);
+    }
+
+    const std::vector<unsigned char>& data() const { return bytes; }
+};
+
+// Reads a payload back. A read past the end yields zeros and clears ok(),
+// so callers check once at the end instead of after every field.
+class StateReader {
+private:
+    const unsigned char* p;
+    const unsigned char* end;
+    bool good = true;
+    std::vector<Job*> jobs;
+
+public:
+    StateReader(const std::vector<unsigned char>& data) : p(data.data()), end(data.data() + data.size()) {}
+
+    template <class T>
+    T get() {
+        T value{};
+        if ((size_t)(end - p) < sizeof(T)) {
+            good = false;
+            p = end;
+            return value;
+        }
+        memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return value;
+    }
+    std::string getString() {
+        uint32_t size = get<uint32_t>();
+        if ((size_t)(end - p) < size) {
+            good = false;
+            p = end;
+            return "";
+        }
+        std::string s((const char*)p, size);
+        p += size;
+        return s;
+    }
+    void setJobs(const std::vector<Job*>& restored) { jobs = restored; }
+    Job* getJob() {
+        int64_t index = get<int64_t>();
+        if (index < 0) return NULL;
+        if ((size_t)index >= jobs.size()) {
+            good = false;
+            return NULL;
+        }
+        return jobs[index];
+    }
+
+    void fail() { good = false; }
+    bool ok() const { return good; }
+    size_t remaining() const { return end - p; }
+    bool atEnd() const { return p == end; }
+};
+
+// Writes a payload to `path` behind the snapshot header. Returns "" or what
+// went wrong.
+inline std::string writeSnapshotFile(const std::string& path, const std::vector<unsigned char>& payload) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return "cannot create the file";
+    uint32_t header[2] = {SNAPSHOT_VERSION, (uint32_t)payload.size()};
+    uint64_t hash = stateHash(payload.data(), payload.size());
+    bool ok = fwrite(SNAPSHOT_MAGIC, 1, 8, file) == 8 && fwrite(header, sizeof(header), 1, file) == 1 &&
+              fwrite(payload.data(), 1, payload.size(), file) == payload.size() &&
+              fwrite(&hash, sizeof(hash), 1, file) == 1;
+    if (fclose(file) != 0) ok = false;
+    return ok ? "" : "write failed";
+}
+
+// Reads the payload of a snapshot file, checking its header and hash.
+// Returns "" or what is wrong with the file.
+inline std::string readSnapshotFile(const std::string& path, std::vector<unsigned char>& payload) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return "cannot open the file";
+    char magic[8];
+    uint32_t header[2];
+    uint64_t hash = 0;
+    std::string error;
+    if (fread(magic, 1, 8, file) != 8 || memcmp(magic, SNAPSHOT_MAGIC, 8) != 0) {
+        error = "not a snapshot";
+    } else if (fread(header, sizeof(header), 1, file) != 1 || header[0] != SNAPSHOT_VERSION) {
+        error = "snapshot of another version or byte order";
+    } else {
+        payload.resize(header[1]);
+        if (fread(payload.data(), 1, payload.size(), file) != payload.size() || fread(&hash, sizeof(hash), 1, file) != 1) {
+            error = "truncated snapshot";
+        } else if (hash != stateHash(payload.data(), payload.size())) {
+            error = "corrupt snapshot (hash mismatch)";
+        }
+    }
+    fclose(file);
+    return error;
+}
+
+// State signatures seen at earlier hyperperiod boundaries, looked up by
+// hash. A hit is confirmed on the whole signature, so a reported repeat is
+// an exact match; from such a boundary on the schedule is periodic.
+class StateHistory {
+private:
+    std::unordered_multimap<uint64_t, size_t> by_hash;
+    std::vector<std::pair<Tick, std::vector<Tick>>> states;
+
+public:
+    // Earliest boundary whose signature equals `sig`, or -1
+    Tick find(const std::vector<Tick>& sig) const {
+        auto range = by_hash.equal_range(stateHash(sig));
+        Tick found = -1;
+        for (auto it = range.first; it != range.second; ++it) {
+            const auto& state = states[it->second];
+            if (state.second == sig && (found < 0 || state.first < found)) found = state.first;
+        }
+        return found;
+    }
+
+    void clear() {
+        by_hash.clear();
+        states.clear();
+    }
+
+    void add(Tick boundary, const std::vector<Tick>& sig) {
+        by_hash.emplace(stateHash(sig), states.size());
+        states.push_back({boundary, sig});
+    }
+
+    void save(StateWriter& out) const {
+        out.put<uint64_t>(states.size());
+        for (const auto& state : states) {
+            out.put<Tick>(state.first);
+            out.put<uint64_t>(state.second.size());
+            for (Tick v : state.second) out.put<Tick>(v);
+        }
+    }
+
+    void load(StateReader& in) {
+        clear();
+        uint64_t count = in.get<uint64_t>();
+        for (uint64_t i = 0; i < count && in.ok(); i++) {
+            Tick boundary = in.get<Tick>();
+            uint64_t size = in.get<uint64_t>();
+            if (size > in.remaining() / sizeof(Tick)) {
+                in.fail();
+                return;
+            }
+            std::vector<Tick> sig(size);
+            for (Tick& v : sig) v = in.get<Tick>();
+            add(boundary, sig);
+        }
+    }
+};
@@ -0,0 +1,62 @@
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free queue between exactly one producer thread and one
+// consumer thread (Lamport's ring buffer). Each side owns one index and
+// only publishes it, with release ordering, once the slot it covers is
+// written or read, so neither side ever waits on the other. The two sides'
+// fields sit on separate cache lines, and each side keeps its last view of
+// the other's index, reloading it only when the ring looks full (producer)
+// or empty (consumer).
+
+const size_t CACHE_LINE = 64;
+
+template <class T>
+class SpscQueue {
+private:
+    std::vector<T> slots;
+    size_t mask;
+
+    // Producer side
+    alignas(CACHE_LINE) std::atomic<size_t> tail{0}; // next slot to write
+    size_t head_seen = 0;
+    // Consumer side
+    alignas(CACHE_LINE) std::atomic<size_t> head{0}; // next slot to read
+    size_t tail_seen = 0;
+
+public:
+    // Room for `capacity` items, rounded up to a power of two
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size *= 2;
+        slots.resize(size);
+        mask = size - 1;
+    }
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer thread. False when the queue is full.
+    bool push(const T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head_seen == slots.size()) {
+            head_seen = head.load(std::memory_order_acquire);
+            if (t - head_seen == slots.size()) return false;
+        }
+        slots[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread. False when the queue is empty.
+    bool pop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail_seen) {
+            tail_seen = tail.load(std::memory_order_acquire);
+            if (h == tail_seen) return false;
+        }
+        item = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
@@ -0,0 +1,102 @@
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+// Response-time statistics collected while simulating, in memory that does
+// not grow with the number of jobs.
+
+// Log-linear (HDR-style) histogram of non-negative integer values. Values
+// below 2^SUB_BITS get a bucket each; above that every power of two is
+// split into 2^(SUB_BITS-1) equal buckets, so a bucket is never wider than
+// 1/32 of the values it holds. Values up to 2^MAX_BITS are kept; larger
+// ones land in the last bucket.
+class LatencyHistogram {
+private:
+    static const int SUB_BITS = 6;
+    static const int SUB_COUNT = 1 << SUB_BITS;
+    static const int HALF = SUB_COUNT / 2;
+    static const int MAX_BITS = 40;
+    static const int BUCKETS = SUB_COUNT + (MAX_BITS - SUB_BITS) * HALF;
+
+    std::vector<uint64_t> counts; // allocated on the first record
+
+    static int indexOf(uint64_t v) {
+        if (v < (uint64_t)SUB_COUNT) return (int)v;
+        int shift = 63 - __builtin_clzll(v) - SUB_BITS + 1;
+        int index = SUB_COUNT + (shift - 1) * HALF + (int)(v >> shift) - HALF;
+        return std::min(index, BUCKETS - 1);
+    }
+    // Largest value that falls into bucket `index`
+    static uint64_t highestIn(int index) {
+        if (index < SUB_COUNT) return index;
+        int shift = (index - SUB_COUNT) / HALF + 1;
+        uint64_t sub = (index - SUB_COUNT) % HALF + HALF;
+        return ((sub + 1) << shift) - 1;
+    }
+
+public:
+    void record(uint64_t v) {
+        if (counts.empty()) counts.assign(BUCKETS, 0);
+        counts[indexOf(v)]++;
+    }
+
+    // Raw bucket counts, for snapshots
+    const std::vector<uint64_t>& buckets() const { return counts; }
+    void setBucket(size_t index, uint64_t count) {
+        if (counts.empty()) counts.assign(BUCKETS, 0);
+        if (index < counts.size()) counts[index] = count;
+    }
+
+    // Smallest bucket bound with at least `fraction` of `total` values at or
+    // below it
+    uint64_t valueAt(double fraction, uint64_t total) const {
+        if (counts.empty() || total == 0) return 0;
+        uint64_t rank = std::max<uint64_t>((uint64_t)std::ceil(fraction * total), 1);
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= rank) return highestIn(i);
+        }
+        return highestIn(BUCKETS - 1);
+    }
+};
+
+// Response times (finish - release) of one task's completed jobs
+struct ResponseStats {
+    uint64_t count = 0;
+    double min = INFINITY;
+    double max = 0;
+    double sum = 0;
+    LatencyHistogram histogram;
+
+    void record(double response) {
+        count++;
+        min = std::min(min, response);
+        max = std::max(max, response);
+        sum += response;
+        histogram.record((uint64_t)std::llround(std::max(response, 0.0)));
+    }
+
+    double mean() const { return count ? sum / count : NAN; }
+    // Histogram percentile, clamped to the exact extremes
+    double percentile(double fraction) const {
+        if (count == 0) return NAN;
+        return std::min(std::max((double)histogram.valueAt(fraction, count), min), max);
+    }
+    // Response-time jitter: spread between the slowest and fastest job
+    double jitter() const { return count ? max - min : NAN; }
+};
+
+// One ResponseStats per task of a run, indexed like the task table
+class ResponseRecorder {
+private:
+    std::vector<ResponseStats> tasks;
+
+public:
+    void reset(size_t task_count) { tasks.assign(task_count, ResponseStats()); }
+    void record(size_t task, double response) { tasks[task].record(response); }
+    size_t size() const { return tasks.size(); }
+    const ResponseStats& of(size_t task) const { return tasks[task]; }
+    ResponseStats& of(size_t task) { return tasks[task]; }
+};
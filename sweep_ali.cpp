@@ -0,0 +1,320 @@
+#include "setup_ali.cpp"
+#include "runner_ali.cpp"
+#include "analysis_ali.cpp"
+#include "taskgen_ali.cpp"
+#include <cmath>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+extern "C" {
+#include "rts_parser.h"
+}
+
+using namespace std;
+
+// Monte Carlo schedulability sweep: for every utilization on a grid,
+// generates random task sets (taskgen_ali.cpp) and reports the fraction of
+// them each policy schedules without a periodic deadline miss.
+//
+// Every policy sees the same sets at a grid point. The server policies run
+// the periodic tasks plus a server of utilization --server-util on top and a
+// few aperiodic requests, so their columns show what the server costs the
+// periodic tasks. Sets are drawn from per-set random streams and results are
+// summed in grid order, so the output only depends on the seed, not on the
+// number of threads.
+
+struct SweepPolicy {
+    const char* name;
+    ParsedServerType server; // SERVER_NONE: one of the periodic schedulers
+};
+
+static const SweepPolicy SWEEP_POLICIES[] = {
+    {"RM", SERVER_NONE},
+    {"DM", SERVER_NONE},
+    {"EDF", SERVER_NONE},
+    {"LLF", SERVER_NONE},
+    {"Background", SERVER_BACKGROUND},
+    {"Poller", SERVER_POLLER},
+    {"Deferrable", SERVER_DEFERRABLE},
+    {"Sporadic", SERVER_SPORADIC},
+    {"TBS", SERVER_TBS},
+    {"CBS", SERVER_CBS},
+};
+const int SWEEP_POLICY_COUNT = sizeof(SWEEP_POLICIES) / sizeof(SWEEP_POLICIES[0]);
+
+struct SweepOptions {
+    GeneratorConfig generator;
+    double u_from = 0.05, u_to = 1.0, u_step = 0.05;
+    int sets = 1000;             // per grid point
+    uint64_t seed = 1;
+    int threads = 0;             // 0 = one per core
+    bool analysis = false;       // decide periodic policies analytically when possible
+    double max_horizon = 1e6;    // longer hyperperiods are cut off here
+    double server_util = 0.2;
+    ParsedSchedulingType server_sched = SCHED_RM;
+    vector<int> policies;        // indices into SWEEP_POLICIES
+};
+
+// Sets generated per pool task
+const int SWEEP_CHUNK = 16;
+
+int gridPoints(const SweepOptions& options) {
+    return (int)floor((options.u_to - options.u_from) / options.u_step + 1e-9) + 1;
+}
+
+double gridUtilization(const SweepOptions& options, int point) {
+    return options.u_from + point * options.u_step;
+}
+
+// Whether a server type only exists under EDF (the parser rejects TBS and
+// CBS under RM), whatever --server-edf says
+bool needsEdf(ParsedServerType type) { return type == SERVER_TBS || type == SERVER_CBS; }
+
+// The server every server policy runs with: the shortest period the
+// generator can produce, so that it has the highest rate-monotonic priority
+ParsedServerConfig sweepServer(const SweepOptions& options, ParsedServerType type) {
+    ParsedServerConfig server;
+    server.type = type;
+    server.period = max(options.generator.period_min / options.generator.granularity, 1) * options.generator.granularity;
+    server.budget = max((int)lround(options.server_util * server.period), 1);
+    server.scheduling = needsEdf(type) ? SCHED_EDF : options.server_sched;
+    return server;
+}
+
+// Whether `sch` meets every periodic deadline of `tasks`
+static bool meetsDeadlines(Scheduler* sch, const vector<Task>& tasks, const SimHorizon& horizon, bool server) {
+    simulate(sch, tasks, horizon, server);
+    bool met = sch->getMissedDeadlines().empty();
+    delete sch;
+    return met;
+}
+
+// Per chunk: accepted sets per selected policy, then the number of sets
+// whose horizon was cut off
+typedef vector<long> SweepCounts;
+
+void runChunk(const SweepOptions& options, int point, int first, int count, SweepCounts& counts) {
+    size_t policies = options.policies.size();
+    counts.assign(policies + 1, 0);
+    ParserState state;
+    init_parser_state(&state);
+    vector<Task> tasks;
+    double u = gridUtilization(options, point);
+
+    for (int s = first; s < first + count; s++) {
+        mt19937_64 rng = setStream(options.seed, point, s);
+        generateTaskSet(rng, options.generator, u, &state);
+        SimHorizon horizon = computeHorizon(&state, options.max_horizon);
+        loadTasksFromParser(&state, tasks);
+        bool truncated = horizon.clamped;
+
+        bool servers_ready = false;
+        SimHorizon server_horizon;
+        vector<Task> server_tasks;
+        for (size_t k = 0; k < policies; k++) {
+            const SweepPolicy& policy = SWEEP_POLICIES[options.policies[k]];
+            bool met;
+            if (policy.server == SERVER_NONE) {
+                Analysis verdict = {UNDECIDED, ""};
+                if (options.analysis) verdict = analyzeSchedulability(&state, policy.name);
+                if (verdict.verdict != UNDECIDED) met = verdict.verdict == SCHEDULABLE;
+                else met = meetsDeadlines(makePeriodicScheduler(policy.name), tasks, horizon, false);
+            } else {
+                if (!servers_ready) {
+                    // Built once per set and shared by the server policies; the
+                    // server type only matters to the horizon through its period
+                    ParserState server_state = state;
+                    server_state.tasks = NULL;
+                    server_state.task_count = server_state.task_capacity = 0;
+                    for (int i = 0; i < state.task_count; i++) appendTask(&server_state, state.tasks[i]);
+                    addAperiodicRequests(rng, options.generator, &server_state);
+                    server_state.server = sweepServer(options, SERVER_POLLER);
+                    server_horizon = computeHorizon(&server_state, options.max_horizon);
+                    loadTasksFromParser(&server_state, server_tasks);
+                    truncated = truncated || server_horizon.clamped;
+                    free_parser_state(&server_state);
+                    servers_ready = true;
+                }
+                Scheduler* sch = makeServerScheduler(sweepServer(options, policy.server));
+                met = meetsDeadlines(sch, server_tasks, server_horizon, true);
+            }
+            if (met) counts[k]++;
+        }
+        if (truncated) counts[policies]++;
+    }
+    free_parser_state(&state);
+}
+
+void printSweep(const SweepOptions& options, const vector<vector<SweepCounts>>& results, ostream& out) {
+    const GeneratorConfig& g = options.generator;
+    out << "# " << (g.method == UUNIFAST ? "UUniFast" : "UUniFast-discard") << ", " << g.tasks << " tasks, periods "
+        << g.period_min << ".." << g.period_max << " (multiples of " << g.granularity << "), "
+        << (g.constrained ? "constrained" : "implicit") << " deadlines" << endl;
+    out << "# " << options.sets << " sets per point, seed " << options.seed;
+    // The server policies share budget and period; the ordering is the one
+    // each actually ran with, EDF for TBS and CBS
+    string rm, edf;
+    ParsedServerConfig server = {};
+    for (int index : options.policies) {
+        if (SWEEP_POLICIES[index].server == SERVER_NONE) continue;
+        server = sweepServer(options, SWEEP_POLICIES[index].server);
+        string& names = server.scheduling == SCHED_EDF ? edf : rm;
+        names += (names.empty() ? "" : ",") + string(SWEEP_POLICIES[index].name);
+    }
+    if (!rm.empty() || !edf.empty()) {
+        out << ", server " << server.budget << "/" << server.period;
+        if (rm.empty() || edf.empty()) {
+            out << " " << (rm.empty() ? "EDF" : "RM");
+        } else {
+            out << " RM (" << rm << ") EDF (" << edf << ")";
+        }
+        out << " with " << g.aperiodic << " aperiodic requests";
+    }
+    out << endl;
+
+    out << "U";
+    for (int index : options.policies) out << "\t" << SWEEP_POLICIES[index].name;
+    out << endl;
+
+    long truncated = 0;
+    out << fixed;
+    for (size_t point = 0; point < results.size(); point++) {
+        SweepCounts total(options.policies.size() + 1, 0);
+        for (const SweepCounts& chunk : results[point]) {
+            for (size_t k = 0; k < total.size(); k++) total[k] += chunk[k];
+        }
+        out << setprecision(2) << gridUtilization(options, point) << setprecision(4);
+        for (size_t k = 0; k < options.policies.size(); k++) out << "\t" << (double)total[k] / options.sets;
+        out << endl;
+        truncated += total.back();
+    }
+    if (truncated > 0) {
+        out << "# " << truncated << " sets simulated only up to t=" << (long long)options.max_horizon
+            << " (hyperperiod too long)" << endl;
+    }
+}
+
+// Comma-separated policy names, as printed in the header
+static bool parsePolicies(const string& list, vector<int>& policies) {
+    policies.clear();
+    stringstream in(list);
+    string name;
+    while (getline(in, name, ',')) {
+        int found = -1;
+        for (int k = 0; k < SWEEP_POLICY_COUNT; k++) {
+            if (name == SWEEP_POLICIES[k].name) found = k;
+        }
+        if (found < 0) {
+            cerr << "Error: Unknown policy '" << name << "'" << endl;
+            return false;
+        }
+        policies.push_back(found);
+    }
+    return !policies.empty();
+}
+
+int main(int argc, char* argv[]) {
+    // -n N          tasks per set
+    // --sets K      sets per utilization point
+    // --from U0 --to U1 --step DU   utilization grid
+    // --periods MIN MAX [--granularity G]   log-uniform periods, multiples of G
+    // --uunifast    plain UUniFast instead of UUniFast-discard
+    // --constrained deadlines uniform in [C, P] instead of D = P
+    // --policies A,B,...   subset of RM,DM,EDF,LLF,Background,Poller,Deferrable,Sporadic,TBS,CBS
+    // --server-util US [--server-edf]   server utilization and base policy
+    //               (TBS and CBS always run under EDF)
+    // --aperiodic K aperiodic requests per set for the server policies
+    // --analysis    skip simulations the schedulability tests can decide
+    // --max-horizon T   cut off longer hyperperiods
+    // --seed S, -j N    random seed, threads (0 = one per core)
+    SweepOptions options;
+    GeneratorConfig& g = options.generator;
+    bool policies_given = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc) {
+            g.tasks = atoi(argv[++i]);
+        } else if (arg == "--sets" && i + 1 < argc) {
+            options.sets = atoi(argv[++i]);
+        } else if (arg == "--from" && i + 1 < argc) {
+            options.u_from = atof(argv[++i]);
+        } else if (arg == "--to" && i + 1 < argc) {
+            options.u_to = atof(argv[++i]);
+        } else if (arg == "--step" && i + 1 < argc) {
+            options.u_step = atof(argv[++i]);
+        } else if (arg == "--periods" && i + 2 < argc) {
+            g.period_min = atoi(argv[++i]);
+            g.period_max = atoi(argv[++i]);
+        } else if (arg == "--granularity" && i + 1 < argc) {
+            g.granularity = atoi(argv[++i]);
+        } else if (arg == "--uunifast") {
+            g.method = UUNIFAST;
+        } else if (arg == "--constrained") {
+            g.constrained = true;
+        } else if (arg == "--policies" && i + 1 < argc) {
+            if (!parsePolicies(argv[++i], options.policies)) return 1;
+            policies_given = true;
+        } else if (arg == "--server-util" && i + 1 < argc) {
+            options.server_util = atof(argv[++i]);
+        } else if (arg == "--server-edf") {
+            options.server_sched = SCHED_EDF;
+        } else if (arg == "--aperiodic" && i + 1 < argc) {
+            g.aperiodic = max(atoi(argv[++i]), 0);
+        } else if (arg == "--analysis") {
+            options.analysis = true;
+        } else if (arg == "--max-horizon" && i + 1 < argc) {
+            options.max_horizon = atof(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = strtoull(argv[++i], NULL, 10);
+        } else if (arg == "-j" && i + 1 < argc) {
+            options.threads = atoi(argv[++i]);
+        } else {
+            cerr << "Usage: " << argv[0] << " [-n tasks] [--sets K] [--from U0] [--to U1] [--step DU]"
+                 << " [--periods MIN MAX] [--granularity G] [--uunifast] [--constrained]"
+                 << " [--policies RM,DM,EDF,LLF,Background,Poller,Deferrable,Sporadic,TBS,CBS] [--server-util US] [--server-edf]"
+                 << " [--aperiodic K] [--analysis] [--max-horizon T] [--seed S] [-j threads]" << endl;
+            return 1;
+        }
+    }
+    if (!policies_given) {
+        for (int k = 0; k < SWEEP_POLICY_COUNT; k++) options.policies.push_back(k);
+    }
+    if (options.threads <= 0) options.threads = max((int)thread::hardware_concurrency(), 1);
+
+    if (g.tasks < 1 || options.sets < 1 || options.u_step <= 0 || options.u_from <= 0 ||
+        options.u_to < options.u_from) {
+        cerr << "Error: Need at least one task and one set, and a grid 0 < U0 <= U1 with DU > 0" << endl;
+        return 1;
+    }
+    if (g.granularity < 1 || g.period_min < g.granularity || g.period_max < g.period_min) {
+        cerr << "Error: Periods need 1 <= G <= MIN <= MAX" << endl;
+        return 1;
+    }
+    if (g.method == UUNIFAST_DISCARD && options.u_to > g.tasks) {
+        cerr << "Error: UUniFast-discard cannot spread U > " << g.tasks << " over " << g.tasks
+             << " tasks without a share above 1" << endl;
+        return 1;
+    }
+    if (options.max_horizon < 1) options.max_horizon = 1;
+
+    int points = gridPoints(options);
+    int chunks = (options.sets + SWEEP_CHUNK - 1) / SWEEP_CHUNK;
+    vector<vector<SweepCounts>> results(points, vector<SweepCounts>(chunks));
+    {
+        WorkStealingPool pool(options.threads);
+        for (int point = 0; point < points; point++) {
+            for (int c = 0; c < chunks; c++) {
+                int first = c * SWEEP_CHUNK;
+                int count = min(SWEEP_CHUNK, options.sets - first);
+                SweepCounts* slot = &results[point][c];
+                pool.submit([&options, point, first, count, slot] { runChunk(options, point, first, count, *slot); });
+            }
+        }
+    }
+    printSweep(options, results, cout);
+    return 0;
+}
@@ -1,34 +1,54 @@
 #include <iostream>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <limits>
+
+// Simulated time is counted in integer ticks, so releases, deadlines and
+// budgets compare exactly over any horizon. How many ticks make one time
+// unit of the input is the run's resolution (SimHorizon::resolution).
+typedef long long Tick;
+const Tick NEVER = std::numeric_limits<Tick>::max(); // no such event
 
 enum TaskTypes {Periodic, Dynamic, Aperiodic};
 enum ServerTypes {None, Background, Poller, Defferable};
+enum Criticality {LoCriticality, HiCriticality};
 
 class Task {
 private:
-    static int num_tasks; 
+    static std::atomic<int> num_tasks; // tasks may be built on several threads
     int id;
     TaskTypes type;
-    double exec_time;
-    double per;
-    double rel_time;
-    double deadline;
+    Tick exec_time;
+    Tick per;
+    Tick rel_time;
+    Tick deadline;
     ServerTypes server;
+    Criticality crit = LoCriticality;
+    Tick exec_hi; // WCET at HI criticality, exec_time for LO tasks
 public:
-    Task(TaskTypes t, double e, double p = 0, double r = 0, double d = 0, ServerTypes s = None) 
-                                        : id(++num_tasks), type(t), exec_time(e), per(p), rel_time(r), server(s) {
+    Task(TaskTypes t, Tick e, Tick p = 0, Tick r = 0, Tick d = 0, ServerTypes s = None) 
+                                        : id(++num_tasks), type(t), exec_time(e), per(p), rel_time(r), server(s), exec_hi(e) {
                                             if(d > 0) deadline = d;
                                             else deadline = p;
                                         }
 
-    int getId() {return id;}
-    TaskTypes getType() {return type;}
-    double getE() {return exec_time;}
-    double getP() {return per;}
-    double getD() {return deadline;}
-    double getR() {return rel_time;}
-    ServerTypes getServer() {return server;}
+    int getId() const {return id;}
+    TaskTypes getType() const {return type;}
+    Tick getE() const {return exec_time;}
+    Tick getP() const {return per;}
+    Tick getD() const {return deadline;}
+    Tick getR() const {return rel_time;}
+    ServerTypes getServer() const {return server;}
+    Criticality getCriticality() const {return crit;}
+    Tick getEHi() const {return exec_hi;}
+    // Execution time of the jobs released from now on (sensitivity analysis)
+    void setE(Tick e) {exec_time = e;}
+    // A HI-criticality task may run for up to `e_hi` >= getE()
+    void setCriticality(Criticality c, Tick e_hi) {
+        crit = c;
+        exec_hi = c == HiCriticality ? e_hi : exec_time;
+    }
 
 /* setters
     double getE() {return exec_time;}
@@ -39,35 +59,84 @@ public:
     */
 };
 
-int Task::num_tasks = 0;
+std::atomic<int> Task::num_tasks(0);
+
+class Job;
+
+// Intrusive slot used by the schedulers' ready queues (readyqueue_ali.cpp)
+struct QueueHook {
+    long seq = 0;          // release order, breaks priority ties first come first served
+    int pos = -1;          // heap index or priority level while queued
+    double key = 0;        // priority a scheduler assigned itself, e.g. a TBS deadline
+    Job* prev = nullptr;
+    Job* next = nullptr;
+};
+
+// Intrusive entry of the simulator's timer wheel (timerwheel_ali.cpp); the
+// owner says what it stands for
+struct TimerNode {
+    Tick when = 0;
+    int level = -1;        // wheel level while armed, -1 otherwise
+    int slot = 0;
+    int kind = 0;
+    size_t task = 0;       // task index, for releases
+    Job* job = nullptr;    // for deadlines
+    TimerNode* prev = nullptr;
+    TimerNode* next = nullptr;
+};
 
 class Job {
 private:
-    std::shared_ptr<Task> task; //this one is for 1-many relation, shared_ptr makes life easier
-    double rem;
+    // Non-owning: tasks live in the caller's contiguous task table, which
+    // outlives every job. The priority keys are copied in so that selection
+    // never has to go back to the task.
+    const Task* task;
+    TaskTypes type;
+    Tick period;
+    Tick rel_deadline;
+    Tick rem;
     bool started;
+    bool retired = false; // completed and removed from the ready queue
     // setted at the creation
-    double abs_deadline;
-    double job_release_time;
+    Tick abs_deadline;
+    Tick job_release_time;
 public:
-    Job(std::shared_ptr<Task> t, double release_time)
-            : task(t), rem(t->getE()), abs_deadline(release_time + t->getD()), job_release_time(release_time), started(false) {
+    QueueHook hook;
+    TimerNode deadline_timer;
+    int core = -1; // processor the job last ran on (multiprocessor runs)
+    // Mixed-criticality runs: getRem() once the job has used up its LO
+    // execution time, -1 if it never runs past it
+    Tick lo_budget_end = -1;
 
+    Job(const Task* t, Tick release_time, long seq = 0)
+            : task(t), type(t->getType()), period(t->getP()), rel_deadline(t->getD()), rem(t->getE()), started(false), abs_deadline(release_time + t->getD()), job_release_time(release_time) {
+                hook.seq = seq;
             }
 
-    std::shared_ptr<Task> getTask() {return task;}
-    double getRem() {return rem;}
-    double getAbsDeadline() {return abs_deadline;}
-    double getJobReleaseTime () { return job_release_time;}
+    const Task* getTask() {return task;}
+    TaskTypes getType() {return type;}
+    Tick getP() {return period;}
+    Tick getD() {return rel_deadline;}
+    Tick getRem() {return rem;}
+    Tick getAbsDeadline() {return abs_deadline;}
+    Tick getJobReleaseTime () { return job_release_time;}
     bool hasStarted() { return started;}
 
+    // Progress of a job brought back from a snapshot
+    void restore(Tick remaining, bool has_started) {
+        rem = remaining;
+        started = has_started;
+    }
+
     bool isComplete() {return rem <= 0;}
+    bool isRetired() {return retired;}
+    void retire() {retired = true;}
 
-    double execute(double time) {
+    Tick execute(Tick time) {
         if(rem > 0) {
             started = true;
             if (rem - time < 0) { 
-                double tmp;
+                Tick tmp = rem;
                 rem = 0;
                 return tmp;
             }
@@ -79,4 +148,53 @@ public:
         return 0;
     }
     // return sth for deadline misses???????????
-};
\ No newline at end of file
+};
+// Slab allocator for jobs. A job's address stays valid until it is handed
+// back with destroy(), and freed slots are reused before a new slab is
+// carved, so memory follows the number of jobs alive at the same time rather
+// than the number released over the whole run.
+class JobPool {
+private:
+    static const int SLAB_SIZE = 256;
+    union Slot {
+        Slot* next_free;
+        alignas(Job) unsigned char storage[sizeof(Job)];
+    };
+    std::vector<std::unique_ptr<Slot[]>> slabs;
+    Slot* free_list = nullptr;
+    int live = 0;
+    int peak = 0;
+
+public:
+    JobPool() {}
+    JobPool(const JobPool&) = delete;
+    JobPool& operator=(const JobPool&) = delete;
+
+    template <class... Args>
+    Job* create(Args&&... args) {
+        if (!free_list) {
+            slabs.emplace_back(new Slot[SLAB_SIZE]);
+            Slot* slab = slabs.back().get();
+            for (int i = SLAB_SIZE - 1; i >= 0; i--) {
+                slab[i].next_free = free_list;
+                free_list = &slab[i];
+            }
+        }
+        Slot* slot = free_list;
+        free_list = slot->next_free;
+        if (++live > peak) peak = live;
+        return new (slot->storage) Job(std::forward<Args>(args)...);
+    }
+
+    void destroy(Job* job) {
+        job->~Job();
+        Slot* slot = reinterpret_cast<Slot*>(job);
+        slot->next_free = free_list;
+        free_list = slot;
+        live--;
+    }
+
+    int liveJobs() { return live; }
+    int peakJobs() { return peak; }
+    size_t capacity() { return slabs.size() * SLAB_SIZE; }
+};
@@ -0,0 +1,129 @@
+#include <random>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+
+extern "C" {
+#include "rts_parser.h"
+}
+
+// Random periodic task sets for schedulability experiments.
+//
+// Utilizations come from UUniFast (Bini & Buttazzo): n shares uniformly
+// distributed over the simplex summing to U. UUniFast-discard redraws the
+// whole vector while any share exceeds 1, which only happens for U > 1.
+// Periods are log-uniform in [period_min, period_max] and rounded down to a
+// multiple of `granularity`, which keeps hyperperiods (and so the simulated
+// horizons) short. C = round(u * P), at least 1.
+//
+// Every random number is derived from std::mt19937_64, whose output is fixed
+// by the standard, with our own conversions instead of the <random>
+// distributions, whose results differ between standard libraries. A seed
+// thus yields the same task sets everywhere.
+
+enum UtilizationMethod { UUNIFAST, UUNIFAST_DISCARD };
+
+struct GeneratorConfig {
+    int tasks = 5;
+    UtilizationMethod method = UUNIFAST_DISCARD;
+    int period_min = 100;
+    int period_max = 1000;
+    int granularity = 100;
+    bool constrained = false; // D uniform in [C, P] instead of D = P
+    int aperiodic = 2;        // requests added by addAperiodicRequests
+};
+
+static uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Independent random stream for set `set` of grid point `point`, so a set
+// does not depend on which thread generates it or in what order
+std::mt19937_64 setStream(uint64_t seed, uint64_t point, uint64_t set) {
+    return std::mt19937_64(splitmix64(splitmix64(splitmix64(seed) ^ point) ^ set));
+}
+
+// Uniform in [0, 1)
+static double uniform01(std::mt19937_64& rng) {
+    return (rng() >> 11) * 0x1.0p-53;
+}
+
+// Uniform integer in [lo, hi]
+static int uniformInt(std::mt19937_64& rng, int lo, int hi) {
+    return lo + (int)(rng() % (uint64_t)(hi - lo + 1));
+}
+
+// n utilizations summing to `total`
+void uunifast(std::mt19937_64& rng, int n, double total, UtilizationMethod method, std::vector<double>& shares) {
+    while (true) {
+        shares.clear();
+        double sum = total;
+        for (int i = 1; i < n; i++) {
+            double next = sum * std::pow(uniform01(rng), 1.0 / (n - i));
+            shares.push_back(sum - next);
+            sum = next;
+        }
+        shares.push_back(sum);
+        if (method == UUNIFAST) return;
+        if (std::all_of(shares.begin(), shares.end(), [](double u) { return u <= 1.0; })) return;
+    }
+}
+
+static void appendTask(ParserState* state, const ParsedTask& task) {
+    if (state->task_count == state->task_capacity) {
+        int capacity = state->task_capacity ? 2 * state->task_capacity : 16;
+        ParsedTask* tasks = (ParsedTask*)realloc(state->tasks, capacity * sizeof(ParsedTask));
+        if (tasks == NULL) abort();
+        state->tasks = tasks;
+        state->task_capacity = capacity;
+    }
+    state->tasks[state->task_count++] = task;
+}
+
+// Replaces the contents of `state` with a periodic set of total utilization
+// `total` (before rounding) and no server
+void generateTaskSet(std::mt19937_64& rng, const GeneratorConfig& config, double total, ParserState* state) {
+    std::vector<double> shares;
+    uunifast(rng, config.tasks, total, config.method, shares);
+    state->task_count = 0;
+    state->server.type = SERVER_NONE;
+    state->server.scheduling = SCHED_NONE;
+
+    double log_min = std::log((double)config.period_min);
+    double log_max = std::log((double)config.period_max + 1);
+    for (double u : shares) {
+        int period = (int)std::exp(log_min + uniform01(rng) * (log_max - log_min));
+        period = std::min(period, config.period_max);
+        period = std::max(period / config.granularity * config.granularity, config.granularity);
+        ParsedTask task;
+        task.type = PARSED_TASK_PERIODIC;
+        task.release_time = 0;
+        task.period = period;
+        task.execution_time = std::max((int)std::lround(u * period), 1);
+        task.deadline = config.constrained ? uniformInt(rng, std::min(task.execution_time, period), period) : period;
+        task.criticality = CRITICALITY_LO;
+        task.execution_time_hi = task.execution_time;
+        appendTask(state, task);
+    }
+}
+
+// Appends config.aperiodic requests released within the longest period,
+// each needing 1 to period_min time units
+void addAperiodicRequests(std::mt19937_64& rng, const GeneratorConfig& config, ParserState* state) {
+    for (int i = 0; i < config.aperiodic; i++) {
+        ParsedTask task;
+        task.type = PARSED_TASK_APERIODIC;
+        task.release_time = uniformInt(rng, 0, config.period_max - 1);
+        task.execution_time = uniformInt(rng, 1, config.period_min);
+        task.period = 0;
+        task.deadline = 0;
+        task.criticality = CRITICALITY_LO;
+        task.execution_time_hi = task.execution_time;
+        appendTask(state, task);
+    }
+}
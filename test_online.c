@@ -0,0 +1,197 @@
+#include "rts_online.h"
+#include <stdio.h>
+#include <string.h>
+
+// Checks of the online scheduling library (rts_online.h): admission, the
+// release path and deadline misses. Every failed check is printed; the exit
+// status is 1 if any failed.
+
+static int failures = 0;
+
+static void check(int ok, const char *what) {
+    if (!ok) {
+        printf("FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+static RtsAdmission admit(RtsScheduler *s, RtsTick wcet, RtsTick period, RtsTick deadline) {
+    RtsTaskParams params = {wcet, period, deadline};
+    return rts_admit(s, &params);
+}
+
+// Releases every admitted task (periods[i] for handle i) strictly
+// periodically from time 0 and runs the schedule up to `horizon`
+static void run_periodic(RtsScheduler *s, const RtsTick *periods, int n, RtsTick horizon) {
+    RtsTick next[16] = {0};
+    RtsTick now = rts_now(s);
+    while (now < horizon) {
+        RtsTick until = horizon;
+        for (int i = 0; i < n; i++) {
+            if (next[i] <= now) {
+                rts_release(s, i, next[i]);
+                next[i] += periods[i];
+            }
+            if (next[i] < until) until = next[i];
+        }
+        rts_tick_until(s, until);
+        now = until;
+    }
+}
+
+// Admits each task in turn and runs the admitted ones; `admitted` receives
+// how many were. Returns the deadline misses.
+static long long admit_and_run(const char *policy, const RtsTick (*tasks)[3], int n, RtsTick horizon,
+                               int *admitted) {
+    RtsScheduler *s = rts_create(policy, n, 16);
+    RtsTick periods[16];
+    *admitted = 0;
+    for (int i = 0; i < n; i++) {
+        if (admit(s, tasks[i][0], tasks[i][1], tasks[i][2]).status == RTS_ADMITTED) periods[(*admitted)++] = tasks[i][1];
+    }
+    run_periodic(s, periods, *admitted, horizon);
+    long long missed = rts_counters(s).missed;
+    rts_destroy(s);
+    return missed;
+}
+
+static void test_create(void) {
+    check(rts_create("LLF", 4, 4) == NULL, "rts_create refuses a policy without an admission test");
+    check(rts_create(NULL, 4, 4) == NULL, "rts_create refuses a NULL policy");
+}
+
+static void test_admission(void) {
+    RtsScheduler *s = rts_create("RM", 2, 4);
+    check(admit(s, 1, 0, 0).status == RTS_INVALID, "a zero period is invalid");
+    check(admit(s, -1, 5, 0).status == RTS_INVALID, "a negative WCET is invalid");
+    RtsAdmission a = admit(s, 1, 4, 0);
+    check(a.status == RTS_ADMITTED && a.task == 0, "RM admits the first task as handle 0");
+    check(strcmp(a.test, "hyperbolic bound") == 0, "RM decides implicit deadlines on the hyperbolic bound");
+    a = admit(s, 6, 7, 0);
+    check(a.status == RTS_REJECTED && a.task == -1, "RM rejects a task its tests cannot prove");
+    a = admit(s, 1, 5, 0);
+    check(a.status == RTS_ADMITTED && a.task == 1, "a rejected task takes no handle");
+    check(admit(s, 1, 100, 0).status == RTS_FULL, "max_tasks bounds the admitted tasks");
+    rts_destroy(s);
+
+    s = rts_create("DM", 4, 4);
+    admit(s, 1, 4, 2);
+    a = admit(s, 2, 6, 5);
+    check(a.status == RTS_ADMITTED && strcmp(a.test, "response-time analysis") == 0,
+          "DM falls back to response-time analysis for constrained deadlines");
+    rts_destroy(s);
+
+    // Density 1/2 + 2/4 + 1/3 > 1, but the demand fits
+    s = rts_create("EDF", 4, 4);
+    check(strcmp(admit(s, 1, 4, 2).test, "density bound") == 0, "EDF decides on the density bound first");
+    admit(s, 2, 6, 4);
+    a = admit(s, 1, 8, 3);
+    check(a.status == RTS_ADMITTED && strcmp(a.test, "processor demand analysis") == 0,
+          "EDF falls back to processor demand analysis");
+    RtsTick periods[] = {4, 6, 8};
+    run_periodic(s, periods, 3, 2400);
+    check(rts_counters(s).missed == 0, "the EDF set admitted on processor demand keeps its deadlines");
+    check(admit(s, 1, 2, 0).status == RTS_REJECTED, "EDF rejects a task that overloads the processor");
+    rts_destroy(s);
+}
+
+// Sets with D > P that a first-job response time admitted for RM and DM,
+// although they overload the processor (U = 9/11 + 6/15 and 20/24 + 3/5)
+static void test_late_deadlines(void) {
+    static const RtsTick dm[][3] = {{9, 11, 27}, {6, 15, 42}};
+    static const RtsTick rm[][3] = {{20, 24, 68}, {3, 5, 6}};
+    int admitted;
+    check(admit_and_run("DM", dm, 2, 20000, &admitted) == 0 && admitted == 0, "DM rejects tasks with D > P");
+    check(admit_and_run("RM", rm, 2, 20000, &admitted) == 0 && admitted == 0, "RM rejects tasks with D > P");
+
+    // EDF's density bound covers D > P
+    static const RtsTick edf[][3] = {{3, 10, 30}, {6, 10, 20}};
+    check(admit_and_run("EDF", edf, 2, 20000, &admitted) == 0 && admitted == 2, "EDF admits D > P on density");
+}
+
+static void test_releases(void) {
+    RtsScheduler *s = rts_create("EDF", 2, 2);
+    admit(s, 2, 10, 0);
+    check(rts_release(s, 0, 0) == 0, "a release goes into the queue");
+    check(rts_release(s, 0, 3) == 0, "a second release fits the queue");
+    check(rts_release(s, 0, 4) == -1, "a full queue refuses a release");
+
+    RtsDecision d = rts_next_decision(s);
+    check(d.task == 0 && d.job == 0 && d.remaining == 2 && d.deadline == 10 && d.until == 2,
+          "the first job runs for its WCET");
+    rts_tick_until(s, 5);
+    d = rts_next_decision(s);
+    check(d.task == -1 && d.until == 10, "a release too soon is held back to one period after the last");
+
+    rts_release(s, 7, 5);
+    rts_tick_until(s, 30);
+    RtsCounters c = rts_counters(s);
+    check(c.released == 2 && c.completed == 2 && c.missed == 0, "both jobs run to completion");
+    check(c.held_back == 1 && c.ignored == 1, "held back and unknown releases are counted");
+    check(rts_now(s) == 30, "rts_tick_until advances the clock to its target");
+    d = rts_next_decision(s);
+    check(d.task == -1 && d.until == RTS_NEVER, "with nothing pending the processor idles for good");
+    rts_destroy(s);
+}
+
+// A task admitted while jobs are live is scheduled with them
+static void test_admit_while_running(void) {
+    RtsScheduler *s = rts_create("RM", 3, 8);
+    admit(s, 3, 10, 0);
+    admit(s, 4, 20, 0);
+    rts_release(s, 0, 0);
+    rts_release(s, 1, 0);
+    rts_tick_until(s, 1);
+    admit(s, 1, 4, 0);
+    rts_release(s, 2, 1);
+    RtsDecision d = rts_next_decision(s);
+    check(d.task == 2 && d.remaining == 1, "the new task's shorter period comes first");
+    rts_tick_until(s, 20);
+    RtsCounters c = rts_counters(s);
+    check(c.completed == 3 && c.missed == 0, "the jobs running before the admission still complete");
+    rts_destroy(s);
+}
+
+// Random sets: whatever is admitted keeps every deadline under periodic
+// releases
+static void test_random_sets(void) {
+    static const char *policies[] = {"RM", "DM", "EDF"};
+    unsigned long long seed = 7;
+    int sets = 0, admitted_tasks = 0, missing = 0;
+    for (int p = 0; p < 3; p++) {
+        for (int n = 0; n < 150; n++) {
+            RtsTick tasks[4][3];
+            int count = 2 + n % 3;
+            for (int i = 0; i < count; i++) {
+                seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                RtsTick period = 3 + (RtsTick)(seed >> 33) % 38;
+                RtsTick wcet = 1 + (RtsTick)(seed >> 13) % (period / 2 + 1);
+                RtsTick deadline = wcet + (RtsTick)(seed >> 45) % (3 * period);
+                tasks[i][0] = wcet;
+                tasks[i][1] = period;
+                tasks[i][2] = deadline;
+            }
+            int admitted;
+            if (admit_and_run(policies[p], (const RtsTick(*)[3])tasks, count, 5000, &admitted) != 0) missing++;
+            admitted_tasks += admitted;
+            sets++;
+        }
+    }
+    check(missing == 0, "no admitted random set misses a deadline");
+    check(admitted_tasks > sets, "the random sets admit tasks beyond their first");
+}
+
+int main(void) {
+    test_create();
+    test_admission();
+    test_late_deadlines();
+    test_releases();
+    test_admit_while_running();
+    test_random_sets();
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All online scheduler checks passed.\n");
+    return 0;
+}
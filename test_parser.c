@@ -11,6 +11,7 @@ int main(int argc, char *argv[]) {
         printf("  P ei pi          - Periodic task (release=0, deadline=period)\n");
         printf("  D ei pi di       - Dynamic task\n");
         printf("  A ri ei          - Aperiodic task\n");
+        printf("  ---              - Starts the next task set (only the first is shown)\n");
         printf("  CONSUMPTION_RULE ONLY_WHEN_EXECUTING\n");
         printf("  REPLENISHMENT_RULE PERIODIC <period>\n");
         return 1;
@@ -38,5 +39,7 @@ int main(int argc, char *argv[]) {
     printf("Parsing complete.\n");
     printf("========================================\n");
 
+    free_parser_state(&state);
+
     return 0;
 }
@@ -0,0 +1,441 @@
+#include "setup_ali.cpp"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+
+using namespace std;
+
+// Checks of the simulator's building blocks: the ready queues (JobHeap,
+// JobFifo, PriorityBuckets), the timer wheel, the parser's task fields and
+// snapshots.
+// Every failed check is printed; the exit status is 1 if any failed.
+
+static int failures = 0;
+
+static void check(bool ok, const string& what) {
+    if (!ok) {
+        printf("FAILED: %s\n", what.c_str());
+        failures++;
+    }
+}
+
+struct DeadlineOrder {
+    bool operator()(Job* a, Job* b) { return a->getAbsDeadline() < b->getAbsDeadline(); }
+};
+
+struct SlackOrder {
+    bool operator()(Job* a, Job* b) { return a->getAbsDeadline() - a->getRem() < b->getAbsDeadline() - b->getRem(); }
+};
+
+// Jobs of their own tasks (one per job so each can have its own deadline)
+struct JobSet {
+    vector<Task> tasks;
+    JobPool pool;
+    vector<Job*> jobs;
+
+    // Job i is released at 0 with relative deadline deadlines[i] and
+    // release number i
+    explicit JobSet(const vector<Tick>& deadlines) {
+        tasks.reserve(deadlines.size());
+        for (Tick d : deadlines) tasks.emplace_back(Periodic, 1, d, 0, d);
+        for (size_t i = 0; i < tasks.size(); i++) jobs.push_back(pool.create(&tasks[i], 0, (long)i));
+    }
+    ~JobSet() {
+        for (Job* job : jobs) pool.destroy(job);
+    }
+};
+
+// The job a linear scan picks: smallest deadline, first released among equals
+static Job* scanMin(const vector<Job*>& queued) {
+    Job* best = NULL;
+    for (Job* job : queued) {
+        if (!best || job->getAbsDeadline() < best->getAbsDeadline() ||
+            (job->getAbsDeadline() == best->getAbsDeadline() && job->hook.seq < best->hook.seq)) {
+            best = job;
+        }
+    }
+    return best;
+}
+
+static void testJobHeap() {
+    JobSet set({30, 10, 20, 10, 40});
+    JobHeap<DeadlineOrder> heap;
+    check(heap.top() == NULL && heap.second() == NULL, "an empty heap has no top");
+    for (Job* job : set.jobs) heap.push(job);
+    check(heap.top() == set.jobs[1], "the heap top is the earliest deadline");
+    check(heap.second() == set.jobs[3], "equal deadlines are served in release order");
+
+    vector<Job*> first;
+    heap.topN(3, first);
+    check(first == vector<Job*>({set.jobs[1], set.jobs[3], set.jobs[2]}), "topN lists the jobs in priority order");
+
+    heap.remove(set.jobs[2]);
+    check(set.jobs[2]->hook.pos == -1 && heap.size() == 4, "remove takes a job from the middle");
+    heap.remove(set.jobs[1]);
+    check(heap.top() == set.jobs[3] && heap.second() == set.jobs[0], "removing the top promotes the runner-up");
+
+    heap.clear();
+    check(heap.empty() && set.jobs[0]->hook.pos == -1, "clear unlinks every job");
+
+    // Keys that change while queued (LLF's deadline - remaining)
+    JobHeap<SlackOrder> slack;
+    for (Job* job : set.jobs) slack.push(job);
+    set.jobs[4]->restore(38, false);
+    slack.update(set.jobs[4]);
+    check(slack.top() == set.jobs[4], "update moves a job whose key dropped to the top");
+    set.jobs[4]->restore(1, false);
+    slack.update(set.jobs[4]);
+    check(slack.top() == set.jobs[1] && slack.second() == set.jobs[3], "update moves it back down");
+    for (Job* job : set.jobs) job->restore(job == set.jobs[0] ? 30 : 0, false);
+    slack.rebuild();
+    check(slack.top() == set.jobs[0], "rebuild reorders after many keys changed");
+    slack.clear();
+
+    // Against a linear scan over random pushes and removals
+    mt19937 rng(1);
+    vector<Tick> deadlines;
+    for (int i = 0; i < 400; i++) deadlines.push_back(1 + rng() % 50);
+    JobSet many(deadlines);
+    vector<Job*> queued;
+    bool agrees = true;
+    for (int step = 0; step < 4000; step++) {
+        Job* job = many.jobs[rng() % many.jobs.size()];
+        if (job->hook.pos < 0) {
+            heap.push(job);
+            queued.push_back(job);
+        } else {
+            heap.remove(job);
+            queued.erase(find(queued.begin(), queued.end(), job));
+        }
+        agrees = agrees && heap.top() == scanMin(queued) && heap.size() == (int)queued.size();
+    }
+    check(agrees, "the heap top matches a linear scan through random pushes and removals");
+    vector<Job*> all;
+    heap.topN(queued.size() + 5, all);
+    bool sorted = all.size() == queued.size();
+    for (size_t i = 1; i < all.size(); i++) sorted = sorted && DeadlineOrder()(all[i], all[i - 1]) == false;
+    check(sorted, "topN past the size lists every job, in order");
+    heap.clear();
+}
+
+static void testPriorityBuckets() {
+    JobSet set({10, 10, 10, 10, 10, 10});
+    JobFifo fifo;
+    for (Job* job : set.jobs) fifo.push(job);
+    fifo.remove(set.jobs[0]);
+    fifo.remove(set.jobs[3]);
+    fifo.remove(set.jobs[5]);
+    bool linked = fifo.front() == set.jobs[1] && set.jobs[1]->hook.next == set.jobs[2] &&
+                  set.jobs[2]->hook.next == set.jobs[4] && set.jobs[4]->hook.next == NULL;
+    check(linked, "JobFifo keeps push order across removals at the head, middle and tail");
+    for (Job* job : {set.jobs[1], set.jobs[2], set.jobs[4]}) fifo.remove(job);
+    check(fifo.empty() && fifo.front() == NULL, "JobFifo empties");
+
+    // 130 levels span three bitmap words
+    PriorityBuckets buckets;
+    buckets.setLevels(130);
+    buckets.push(set.jobs[0], 129);
+    buckets.push(set.jobs[1], 70);
+    buckets.push(set.jobs[2], 70);
+    buckets.push(set.jobs[3], 3);
+    check(buckets.top() == set.jobs[3] && buckets.size() == 4, "the highest level (lowest number) comes first");
+    buckets.remove(set.jobs[3]);
+    check(buckets.top() == set.jobs[1], "a drained level hands over to the next, in push order");
+    vector<Job*> order;
+    buckets.topN(10, order);
+    check(order == vector<Job*>({set.jobs[1], set.jobs[2], set.jobs[0]}), "topN walks the levels in priority order");
+    buckets.remove(set.jobs[1]);
+    buckets.remove(set.jobs[2]);
+    check(buckets.top() == set.jobs[0], "the last word of the bitmap is found");
+    buckets.push(set.jobs[4], 0);
+    check(buckets.top() == set.jobs[4], "a push above the cached level takes over");
+    buckets.remove(set.jobs[4]);
+    buckets.remove(set.jobs[0]);
+    check(buckets.empty() && buckets.top() == NULL, "PriorityBuckets empties");
+}
+
+static void testTimerWheel() {
+    TimerWheel wheel;
+    check(wheel.nextExpiry() == NEVER, "an empty wheel has no expiry");
+
+    // Times on every level the clock has to cascade through
+    const Tick when[] = {0, 5, 63, 64, 65, 4095, 4096, 300000, 1LL << 30, (1LL << 40) + 7, 5};
+    const int n = sizeof(when) / sizeof(when[0]);
+    TimerNode nodes[n];
+    for (int i = 0; i < n; i++) wheel.insert(&nodes[i], when[i]);
+    check(wheel.nextExpiry() == 0, "the earliest timer is the next expiry");
+
+    vector<TimerNode*> due;
+    wheel.advance(4, due);
+    check(due.size() == 1 && due[0] == &nodes[0], "advance returns the timers due by then");
+    due.clear();
+    wheel.advance(5, due);
+    check(due.size() == 2 && due[0]->when == 5 && due[1]->when == 5, "equal expiries come out together");
+    due.clear();
+
+    wheel.remove(&nodes[5]);
+    check(nodes[5].level == -1, "remove disarms a timer");
+    wheel.remove(&nodes[5]);
+    wheel.insert(&nodes[6], 70);
+    check(wheel.nextExpiry() == 63, "re-arming keeps the earliest expiry");
+
+    wheel.advance(1LL << 41, due);
+    vector<Tick> times;
+    for (TimerNode* node : due) times.push_back(node->when);
+    check(times == vector<Tick>({63, 64, 65, 70, 300000, 1LL << 30, (1LL << 40) + 7}),
+          "cascading delivers far timers in time order");
+    check(wheel.empty() && wheel.nextExpiry() == NEVER, "every timer fired once");
+
+    // Against a sorted reference, arming while the clock moves
+    mt19937_64 rng(2);
+    vector<TimerNode> pool(500);
+    vector<pair<Tick, TimerNode*>> pending;
+    Tick now = 1LL << 41;
+    bool agrees = true;
+    for (int step = 0; step < 20000; step++) {
+        TimerNode* node = &pool[rng() % pool.size()];
+        if (node->level < 0) {
+            Tick at = now + (Tick)(rng() % (1ULL << (rng() % 30)));
+            wheel.insert(node, at);
+            pending.push_back({at, node});
+        } else if (rng() % 4 == 0) {
+            wheel.remove(node);
+            pending.erase(find(pending.begin(), pending.end(), make_pair(node->when, node)));
+        }
+        if (step % 7 == 0) {
+            now += rng() % 5000;
+            due.clear();
+            wheel.advance(now, due);
+            vector<pair<Tick, TimerNode*>> expected;
+            for (auto it = pending.begin(); it != pending.end();) {
+                if (it->first <= now) {
+                    expected.push_back(*it);
+                    it = pending.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            sort(expected.begin(), expected.end());
+            bool ordered = due.size() == expected.size();
+            for (size_t i = 0; ordered && i < due.size(); i++) {
+                ordered = due[i]->when == expected[i].first && (i == 0 || due[i - 1]->when <= due[i]->when);
+            }
+            Tick next = NEVER;
+            for (const auto& p : pending) next = min(next, p.first);
+            agrees = agrees && ordered && wheel.nextExpiry() == next;
+        }
+    }
+    check(agrees, "the wheel matches a sorted list through random arming, removal and advances");
+}
+
+struct ParsedSets {
+    vector<vector<ParsedTask>> sets;
+    vector<ParsedServerConfig> servers;
+};
+
+static int keepSet(ParserState* state, int, void* user) {
+    ParsedSets* parsed = (ParsedSets*)user;
+    parsed->sets.emplace_back(state->tasks, state->tasks + state->task_count);
+    parsed->servers.push_back(state->server);
+    return 0;
+}
+
+static int parseText(const string& text, ParsedSets& parsed) {
+    return parse_buffer(text.data(), text.size(), "test", keepSet, &parsed);
+}
+
+static void testParser() {
+    ParsedSets parsed;
+    int sets = parseText("# mixed criticality\n"
+                         "P 2 10 HI 4\n"
+                         "P 1 3 15 12 LO\n"
+                         "P 0 1 12 8 HI 3\n"
+                         "---\n"
+                         "D 2 9 7\n"
+                         "A 4 2\n"
+                         "S 2 6 CBS EDF\n",
+                         parsed);
+    check(sets == 2 && parsed.sets.size() == 2, "a delimiter starts a second set");
+    if (parsed.sets.size() == 2 && parsed.sets[0].size() == 3 && parsed.sets[1].size() == 2) {
+        const ParsedTask* t = parsed.sets[0].data();
+        check(t[0].criticality == CRITICALITY_HI && t[0].execution_time == 2 && t[0].execution_time_hi == 4 &&
+                  t[0].deadline == 10,
+              "'P ei pi HI ei_hi' reads a HI task");
+        check(t[1].criticality == CRITICALITY_LO && t[1].execution_time_hi == t[1].execution_time &&
+                  t[1].release_time == 1 && t[1].deadline == 12,
+              "a LO task's HI execution time is its LO one");
+        check(t[2].criticality == CRITICALITY_HI && t[2].execution_time_hi == 3 && t[2].deadline == 8,
+              "the criticality follows an explicit deadline");
+        const ParsedTask* u = parsed.sets[1].data();
+        check(u[0].type == PARSED_TASK_DYNAMIC && u[0].criticality == CRITICALITY_LO && u[1].type == PARSED_TASK_APERIODIC,
+              "dynamic and aperiodic tasks are LO");
+        check(parsed.servers[0].type == SERVER_NONE && parsed.servers[1].type == SERVER_CBS &&
+                  parsed.servers[1].scheduling == SCHED_EDF && parsed.servers[1].budget == 2,
+              "each set has its own server");
+    } else {
+        check(false, "the sets hold 3 and 2 tasks");
+    }
+
+    ParsedSets bad;
+    check(parseText("P 4 10 HI 3\n", bad) < 0, "a HI execution time below the LO one is an error");
+    check(parseText("P 4 10 HI\n", bad) < 0, "HI needs an execution time");
+    check(parseText("S 0 6 TBS EDF\n", bad) < 0, "a TBS needs a budget");
+
+    // No fixed task limit (the old table held 50)
+    string big;
+    for (int i = 0; i < 5000; i++) big += "P " + to_string(1 + i % 3) + " " + to_string(100 + i) + "\n";
+    big += "---\n---\n";
+    ParsedSets large;
+    sets = parseText(big, large);
+    check(sets == 2 && large.sets[0].size() == 5000 && large.sets[0][4999].period == 5099,
+          "a set of 5000 tasks parses whole");
+    check(sets == 2 && large.sets[1].empty(), "back-to-back delimiters close an empty set, the last opens none");
+}
+
+// The first set of `text` as the simulator front ends see it
+static ParserState firstSet(const string& text, ParsedSets& parsed) {
+    ParserState state = {};
+    if (parseText(text, parsed) > 0) {
+        state.tasks = parsed.sets[0].data();
+        state.task_count = (int)parsed.sets[0].size();
+        state.server = parsed.servers[0];
+    }
+    return state;
+}
+
+static void testHorizon() {
+    ParsedSets small, large;
+    ParserState state = firstSet("P 1 4\nP 0 2 6 6\n", small);
+    SimHorizon horizon = computeHorizon(&state, HORIZON_LIMIT, 1000);
+    check(horizon.hyperperiod == 12000 && horizon.length == 24000 && !horizon.clamped,
+          "the horizon is two hyperperiods in ticks");
+
+    // Scaled caps and hyperperiods that overflowed a Tick
+    horizon = computeHorizon(&state, HORIZON_LIMIT, 20000000000LL);
+    check(horizon.length == 24 * 10000000000LL * 2 && !horizon.clamped, "a huge resolution scales a short horizon");
+    state = firstSet("P 1 2000000000\nP 1 1999999999\n", large);
+    horizon = computeHorizon(&state, HORIZON_LIMIT, 20000000000LL);
+    check(horizon.clamped && horizon.hyperperiod == 0 && horizon.length == NEVER / 20000000000LL * 20000000000LL,
+          "a cap past the Tick range is lowered to fit");
+    horizon = computeHorizon(&state, 1e30, 1);
+    check(!horizon.clamped && horizon.hyperperiod == 3999999998000000000LL && horizon.length == 2 * horizon.hyperperiod,
+          "a limit past the Tick range keeps any horizon that fits");
+    check(SimHorizon(0, RESOLUTION_LIMIT).ticks(1e30) == NEVER, "ticks() saturates at NEVER");
+}
+
+// What a run leaves behind, for comparing a split run with a whole one
+struct RunOutcome {
+    vector<Tick> trace;  // start, end, seq, task, deadline of every slice
+    vector<long> missed; // seq of every job past its deadline
+    vector<double> responses;
+    vector<long> counts; // end, released, finished, preemptions, switches
+};
+
+static RunOutcome outcomeOf(Scheduler* sch, const SimResult& result, const ResponseRecorder& responses) {
+    RunOutcome outcome;
+    for (const TraceRecord& record : sch->getLogs()) {
+        outcome.trace.insert(outcome.trace.end(), {record.start, record.end, record.job.seq, record.job.task_id,
+                                                   record.job.abs_deadline});
+    }
+    for (const JobRecord& job : sch->getMissedDeadlines()) outcome.missed.push_back(job.seq);
+    for (size_t i = 0; i < responses.size(); i++) {
+        outcome.responses.insert(outcome.responses.end(), {(double)responses.of(i).count, responses.of(i).sum});
+    }
+    outcome.counts = {result.end, result.released, sch->getFinishedCount(), result.preemptions, result.switches};
+    return outcome;
+}
+
+static bool operator==(const RunOutcome& a, const RunOutcome& b) {
+    return a.trace == b.trace && a.missed == b.missed && a.responses == b.responses && a.counts == b.counts;
+}
+
+// Runs `make()`'s scheduler over the first set of `text` whole, then split
+// at each of `stops` (save, then resume in a fresh scheduler), and checks
+// that every split run ends exactly as the whole one
+template <class Make>
+static void checkSplitRuns(const string& what, const string& text, bool serve_aperiodic, Make make) {
+    ParsedSets parsed;
+    if (parseText(text, parsed) < 1) {
+        check(false, what + ": the set parses");
+        return;
+    }
+    ParserState state = {};
+    state.tasks = parsed.sets[0].data();
+    state.task_count = (int)parsed.sets[0].size();
+    vector<Task> tasks;
+    loadTasksFromParser(&state, tasks);
+    SimHorizon horizon(240);
+    const string path = "test_sim.snap";
+
+    unique_ptr<Scheduler> whole(make());
+    ResponseRecorder responses;
+    SimResult result = simulate(whole.get(), tasks, horizon, serve_aperiodic, &responses);
+    RunOutcome expected = outcomeOf(whole.get(), result, responses);
+
+    bool saved = true, resumed = true, same = true;
+    for (Tick stop : {0, 1, 7, 33, 101, 239}) {
+        unique_ptr<Scheduler> first(make());
+        SimCheckpoint save;
+        save.save_to = path;
+        save.stop_at = stop;
+        simulate(first.get(), tasks, horizon, serve_aperiodic, &responses, &save);
+        saved = saved && save.saved && save.error.empty();
+
+        unique_ptr<Scheduler> second(make());
+        SimCheckpoint resume;
+        resume.resume_from = path;
+        result = simulate(second.get(), tasks, horizon, serve_aperiodic, &responses, &resume);
+        resumed = resumed && resume.resumed && resume.error.empty();
+        same = same && outcomeOf(second.get(), result, responses) == expected;
+    }
+    remove(path.c_str());
+    check(saved && resumed, what + ": every split run saves and resumes its snapshot");
+    check(same, what + ": a resumed run ends exactly as the uninterrupted one");
+}
+
+static void testSnapshots() {
+    const string periodic = "P 1 4\nP 2 6\nP 3 10\n";
+    const string overloaded = "P 2 5\nP 3 7\nP 0 2 9 8\n";
+    for (const char* name : PERIODIC_SCHEDULERS) {
+        checkSplitRuns(string(name), periodic, false, [&] { return makePeriodicScheduler(name); });
+        checkSplitRuns(string(name) + " with misses", overloaded, false, [&] { return makePeriodicScheduler(name); });
+    }
+    const string mixed = "P 2 10 HI 4\nP 3 8\nP 0 1 12 8 HI 3\nP 2 15\n";
+    for (const char* name : MIXED_CRITICALITY_SCHEDULERS) {
+        checkSplitRuns(string(name), mixed, false, [&] { return makePeriodicScheduler(name); });
+    }
+
+    // Every server keeps budget state of its own (saveState/loadState)
+    const string served = "P 1 5\nP 2 8\nA 1 2\nA 4 3\nA 9 1\nA 15 2\nA 40 4\nA 41 1\n";
+    const ParsedServerType servers[] = {SERVER_BACKGROUND, SERVER_POLLER, SERVER_DEFERRABLE,
+                                        SERVER_SPORADIC,   SERVER_TBS,    SERVER_CBS};
+    for (ParsedServerType type : servers) {
+        for (ParsedSchedulingType order : {SCHED_RM, SCHED_EDF}) {
+            ParsedServerConfig server = {};
+            server.type = type;
+            server.scheduling = order;
+            server.period = 6;
+            server.budget = 2;
+            unique_ptr<Scheduler> named(makeServerScheduler(server));
+            string what = named->getName() + (order == SCHED_RM ? " (RM)" : " (EDF)");
+            checkSplitRuns(what, served, true, [&] { return makeServerScheduler(server); });
+        }
+    }
+}
+
+int main() {
+    testJobHeap();
+    testPriorityBuckets();
+    testTimerWheel();
+    testParser();
+    testHorizon();
+    testSnapshots();
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All simulator checks passed.\n");
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// Hierarchical timer wheel (Varghese & Lauck) over integer ticks, feeding
+// the simulator its releases, deadlines and budget replenishments.
+//
+// Times are read as base-64 digits. There are LEVELS wheels of 64 slots; a
+// timer due at `when` hangs on the level of the highest digit in which
+// `when` and the wheel's clock differ, in the slot of its own digit there.
+// Every timer one level holds is therefore later than every timer on the
+// levels below, and within a level the slots are in time order. Whenever
+// the clock enters a new slot of some level, that slot's timers move down
+// (cascade) to the level they now belong to; each timer moves at most
+// LEVELS times. Arming and disarming are O(1) list operations, and finding
+// the earliest timer is a bit scan, plus a walk of one slot when the next
+// timer is not in the current 64-tick window.
+class TimerWheel {
+private:
+    static const int BITS = 6;
+    static const int SLOTS = 1 << BITS;
+    static const int LEVELS = (64 + BITS - 1) / BITS;
+
+    Tick now = 0;
+    TimerNode* slots[LEVELS][SLOTS] = {};
+    uint64_t occupied[LEVELS] = {}; // bit s set while slot s is non-empty
+    int count = 0;
+    Tick earliest = NEVER; // cached nextExpiry(), valid while `known`
+    bool known = true;
+
+    static int digit(Tick t, int level) { return (int)(((uint64_t)t >> (level * BITS)) & (SLOTS - 1)); }
+
+    void link(TimerNode* node) {
+        uint64_t diff = (uint64_t)(node->when ^ now);
+        int level = diff ? (63 - __builtin_clzll(diff)) / BITS : 0;
+        int slot = digit(node->when, level);
+        node->level = level;
+        node->slot = slot;
+        node->prev = nullptr;
+        node->next = slots[level][slot];
+        if (node->next) node->next->prev = node;
+        slots[level][slot] = node;
+        occupied[level] |= 1ULL << slot;
+    }
+
+    void unlink(TimerNode* node) {
+        if (node->prev) node->prev->next = node->next;
+        else slots[node->level][node->slot] = node->next;
+        if (node->next) node->next->prev = node->prev;
+        if (!slots[node->level][node->slot]) occupied[node->level] &= ~(1ULL << node->slot);
+        node->level = -1;
+    }
+
+    // Detaches the list of one slot
+    TimerNode* take(int level, int slot) {
+        TimerNode* list = slots[level][slot];
+        slots[level][slot] = nullptr;
+        occupied[level] &= ~(1ULL << slot);
+        return list;
+    }
+
+    // Moves the clock to t, which no pending timer precedes, cascading the
+    // slots t enters
+    void setNow(Tick t) {
+        Tick old = now;
+        now = t;
+        for (int level = LEVELS - 1; level > 0; level--) {
+            if (((uint64_t)old >> (level * BITS)) == ((uint64_t)t >> (level * BITS))) continue;
+            for (TimerNode* node = take(level, digit(t, level)); node;) {
+                TimerNode* next = node->next;
+                link(node);
+                node = next;
+            }
+        }
+    }
+
+    Tick scanEarliest() {
+        for (int level = 0; level < LEVELS; level++) {
+            if (!occupied[level]) continue;
+            int slot = __builtin_ctzll(occupied[level]);
+            if (level == 0) return (now & ~(Tick)(SLOTS - 1)) | slot;
+            Tick best = NEVER;
+            for (TimerNode* node = slots[level][slot]; node; node = node->next) best = std::min(best, node->when);
+            return best;
+        }
+        return NEVER;
+    }
+
+public:
+    TimerWheel() {}
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    bool empty() const { return count == 0; }
+
+    // Disarms every timer and moves the clock back to 0
+    void clear() {
+        for (int level = 0; level < LEVELS; level++) {
+            for (int slot = 0; slot < SLOTS; slot++) {
+                for (TimerNode* node = slots[level][slot]; node; node = node->next) node->level = -1;
+                slots[level][slot] = nullptr;
+            }
+            occupied[level] = 0;
+        }
+        now = 0;
+        count = 0;
+        earliest = NEVER;
+        known = true;
+    }
+
+    // Arms `node` for `when`, which must not lie before the last advance();
+    // re-arms it if it was pending
+    void insert(TimerNode* node, Tick when) {
+        if (node->level >= 0) remove(node);
+        node->when = when;
+        link(node);
+        count++;
+        if (known && when < earliest) earliest = when;
+    }
+
+    void remove(TimerNode* node) {
+        if (node->level < 0) return;
+        unlink(node);
+        count--;
+        if (node->when == earliest) known = false;
+    }
+
+    // Earliest pending expiry, NEVER if there is none
+    Tick nextExpiry() {
+        if (!known) {
+            earliest = scanEarliest();
+            known = true;
+        }
+        return earliest;
+    }
+
+    // Moves the clock to t and appends every timer due at or before t to
+    // `due`, earliest first (in no particular order among equal times)
+    void advance(Tick t, std::vector<TimerNode*>& due) {
+        while (count > 0) {
+            Tick when = nextExpiry();
+            if (when > t) break;
+            // Cascading to `when` brings all of its timers down to level 0
+            setNow(when);
+            for (TimerNode* node = take(0, digit(when, 0)); node; node = node->next) {
+                node->level = -1;
+                due.push_back(node);
+                count--;
+            }
+            known = false;
+        }
+        if (t > now) setNow(t);
+    }
+};
@@ -0,0 +1,135 @@
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// Columnar binary trace of one run, streamed while the simulation goes on
+// and mapped by the visualizers with numpy.memmap (rts_trace.py) instead of
+// re-parsing the text schedule. Layout:
+//
+//   TraceHeader
+//   row groups of rows_per_group rows; in each group one column after the
+//   other, each a plain array of rows_per_group values:
+//     start, end, seq, deadline (int64_t), task, core (int32_t),
+//     kind, type (uint8_t)
+//
+// Every group but the last is full, so each column of each group sits at a
+// fixed offset, and only one group is ever buffered in memory; the last
+// group has the same layout with the rows that are left. Times are in
+// ticks, `resolution` per time unit. `rows` counts the valid rows and stays
+// -1 while the run is still writing. Fields are in the byte order of the
+// machine that wrote the file, as in the task batches (rts_batch.h).
+
+#define TRACE_MAGIC "RTSTRACE"
+const uint32_t TRACE_VERSION = 1;
+const uint32_t TRACE_GROUP_ROWS = 4096;
+
+enum TraceRowKind : uint8_t {
+    TRACE_SLICE = 0, // the job (seq -1: nobody) held `core` over [start, end)
+    TRACE_MISS = 1,  // the job missed its deadline, start = end = deadline
+};
+
+struct TraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t rows_per_group;
+    int64_t rows;
+    int64_t resolution;
+    int32_t cores;
+    int32_t reserved;
+    char scheduler[88]; // NUL-terminated
+};
+static_assert(sizeof(TraceHeader) == 128, "trace header layout");
+
+// Writes the rows of one run to a trace file as they become final. Errors
+// are kept and reported by close(), so the simulator never checks them.
+class TraceExport {
+private:
+    FILE* file = nullptr;
+    std::string path;
+    TraceHeader header;
+    std::vector<int64_t> start, end, seq, deadline;
+    std::vector<int32_t> task, core;
+    std::vector<uint8_t> kind, type;
+    int64_t rows = 0;
+    bool failed = false;
+
+    template <class T>
+    void writeColumn(std::vector<T>& column) {
+        if (fwrite(column.data(), sizeof(T), column.size(), file) != column.size()) failed = true;
+        column.clear();
+    }
+
+    void writeGroup() {
+        writeColumn(start);
+        writeColumn(end);
+        writeColumn(seq);
+        writeColumn(deadline);
+        writeColumn(task);
+        writeColumn(core);
+        writeColumn(kind);
+        writeColumn(type);
+    }
+
+    void add(TraceRowKind k, Tick s, Tick e, long job_seq, int task_id, int job_type, Tick abs_deadline, int c) {
+        if (!file) return;
+        start.push_back(s);
+        end.push_back(e);
+        seq.push_back(job_seq);
+        deadline.push_back(abs_deadline);
+        task.push_back(task_id);
+        core.push_back(c);
+        kind.push_back(k);
+        type.push_back(job_type);
+        rows++;
+        if (start.size() == TRACE_GROUP_ROWS) writeGroup();
+    }
+
+public:
+    TraceExport() {}
+    TraceExport(const TraceExport&) = delete;
+    TraceExport& operator=(const TraceExport&) = delete;
+    ~TraceExport() { close(); }
+
+    // Starts `filename` for a run of `scheduler` on `cores` processors.
+    // Returns "" or what went wrong.
+    std::string open(const std::string& filename, const std::string& scheduler, Tick resolution, int cores = 1) {
+        path = filename;
+        file = fopen(filename.c_str(), "wb");
+        if (!file) return "cannot create the file";
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, TRACE_MAGIC, 8);
+        header.version = TRACE_VERSION;
+        header.rows_per_group = TRACE_GROUP_ROWS;
+        header.rows = -1;
+        header.resolution = resolution;
+        header.cores = cores;
+        strncpy(header.scheduler, scheduler.c_str(), sizeof(header.scheduler) - 1);
+        if (fwrite(&header, sizeof(header), 1, file) != 1) failed = true;
+        return "";
+    }
+
+    const std::string& filename() const { return path; }
+
+    // Empty slices are left out
+    void slice(Tick s, Tick e, long job_seq, int task_id, int job_type, Tick abs_deadline, int c) {
+        if (e > s) add(TRACE_SLICE, s, e, job_seq, task_id, job_type, abs_deadline, c);
+    }
+
+    void miss(long job_seq, int task_id, int job_type, Tick abs_deadline) {
+        add(TRACE_MISS, abs_deadline, abs_deadline, job_seq, task_id, job_type, abs_deadline, -1);
+    }
+
+    // Writes the last group and the row count. Returns "" or what went
+    // wrong; later calls do nothing.
+    std::string close() {
+        if (!file) return "";
+        if (!start.empty()) writeGroup();
+        header.rows = rows;
+        if (fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, file) != 1) failed = true;
+        if (fclose(file) != 0) failed = true;
+        file = nullptr;
+        return failed ? "write failed" : "";
+    }
+};